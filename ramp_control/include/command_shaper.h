@@ -0,0 +1,44 @@
+#ifndef COMMAND_SHAPER_H
+#define COMMAND_SHAPER_H
+
+#include "geometry_msgs/Twist.h"
+#include <math.h>
+
+
+/**
+ * Limits the acceleration and jerk of the twists sent to the robot
+ *
+ * Each axis (linear.x and angular.z) keeps the last velocity and acceleration
+ * it sent. A new twist is reached as fast as the limits allow, and the
+ * acceleration is reduced ahead of time so the velocity does not overshoot.
+ * A jerk limit of 0 only limits acceleration.
+ */
+class CommandShaper {
+public:
+
+  CommandShaper();
+  ~CommandShaper();
+
+  void setLimits(const double a_linear, const double a_angular, const double j_linear, const double j_angular);
+
+  // Move toward desired for one cycle of dt seconds, a_linear and a_angular are the 
+  // feedforward accelerations of the reference over the cycle
+  void shape(const geometry_msgs::Twist& desired, const double a_linear, const double a_angular, 
+      const double dt, geometry_msgs::Twist& result);
+
+  // Set the state after a twist was sent without shaping
+  void reset(const geometry_msgs::Twist& twist);
+
+private:
+
+  // Velocity and acceleration of one axis, returns the new velocity
+  const double shapeAxis(const double target, const double a_max, const double j_max, const double dt, double& v, double& a) const;
+
+  double a_max_linear_, a_max_angular_;
+  double j_max_linear_, j_max_angular_;
+
+  double v_linear_, v_angular_;
+  double a_linear_, a_angular_;
+};
+
+#endif
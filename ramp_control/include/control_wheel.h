@@ -0,0 +1,55 @@
+#ifndef CONTROL_WHEEL_H
+#define CONTROL_WHEEL_H
+
+#include "mobile_robot.h"
+
+// Number of slots, the longest control period is this many wheel cycles
+#define WHEEL_SLOTS 256
+
+
+/**
+ * Runs the control cycles of many robots from one thread
+ *
+ * The wheel turns one slot every resolution seconds. Each slot holds the
+ * robots whose control cycle is due then, and after its cycle a robot is
+ * put back period slots ahead. Robots with the same rate are spread over
+ * the slots of one period so their cycles do not all land on the same turn.
+ */
+class ControlWheel {
+public:
+
+  ControlWheel();
+  ~ControlWheel();
+
+  // Time between slots, the robots' periods are rounded to a multiple of it
+  void setResolution(const double resolution);
+
+  // Add a robot that is cycled rate times per second, only before start
+  void add(MobileRobot* robot, const double rate);
+
+  // A priority > 0 requests SCHED_FIFO for the thread
+  void start(const int priority);
+  void stop();
+
+private:
+
+  struct Entry
+  {
+    MobileRobot*  robot;
+    unsigned int  period;
+  };
+
+  void run();
+
+  Utility                           utility_;
+  double                            resolution_;
+  std::vector< std::vector<Entry> > slots_;
+  std::vector<Entry>                due_;
+  unsigned int                      tick_;
+  unsigned int                      num_robots_;
+
+  boost::thread                     thread_;
+  boost::atomic<bool>               running_;
+};
+
+#endif
@@ -7,9 +7,56 @@
 #include "geometry_msgs/Twist.h"
 #include "tf/transform_datatypes.h"
 #include "ramp_msgs/MotionState.h"
+#include "ramp_msgs/ObstacleList.h"
 #include "std_msgs/Bool.h"
+#include "triple_buffer.h"
+#include "state_estimator.h"
+#include "command_shaper.h"
+#include <boost/thread.hpp>
 #include <math.h>
 
+
+/** Everything the control thread needs to follow one trajectory, one entry per point */
+struct ControlPlan
+{
+  // Only the points are kept up to date when a trajectory is spliced in
+  ramp_msgs::RampTrajectory trajectory;
+  uint32_t                  id;
+  bool                      spliced;
+  ros::Time                 t_start;
+  std::vector<double>       times; 
+  std::vector<double>       speeds_linear;
+  std::vector<double>       speeds_angular;
+  std::vector<double>       accelerations_linear;
+  std::vector<double>       accelerations_angular;
+};
+
+
+/** Obstacle positions and velocities from the latest list, in the world frame */
+struct WatchdogObstacles
+{
+  ros::Time                 t_received;
+  std::vector<double>       x, y;
+  std::vector<double>       v_x, v_y;
+};
+
+
+/** Pose and speeds the robot should have at some time, in the world frame */
+struct ControlReference
+{
+  double x, y, theta;
+  double v, w;
+  double a_v, a_w;
+};
+
+/** What moveOnTrajectory does with the plan for one control cycle */
+enum CycleAction
+{
+  CYCLE_TRACK,
+  CYCLE_STOP,         // Held by an imminent collision from the planner
+  CYCLE_DECELERATE    // The watchdog found a collision on the plan
+};
+
 class MobileRobot
 {
   public:
@@ -19,15 +66,28 @@ class MobileRobot
   /** Methods **/ 
   void init(ros::NodeHandle& h);
 
+  // Start and stop the thread that sends twists at a fixed rate
+  // A priority > 0 requests SCHED_FIFO for the thread
+  void startControl(const double rate, const int priority);
+  void stopControl();
+
+  // For when another thread calls moveOnTrajectory at rate, like a ControlWheel
+  void initControl(const double rate);
+
   void moveOnTrajectory();
   void moveOnTrajectoryRot(const ramp_msgs::RampTrajectory traj, bool simulation);
   void odomCb(const nav_msgs::Odometry& msg);
   void updateTrajectory(const ramp_msgs::RampTrajectory& msg); 
   void imminentCollisionCb(const std_msgs::Bool msg); 
+  void obstaclesCb(const ramp_msgs::ObstacleList& msg);
   void updateCallback(const ros::TimerEvent&);
   void sendTwist(const geometry_msgs::Twist twist) const;
   void controlCycle(geometry_msgs::Twist twist, ros::Time end_time, ros::Rate r);
 
+  // Action of a cycle on a plan from the imminent collision flag and the cycle's watchdog check
+  // watchdog_coll is the state last reported to the planner, notify is set if it has to be reported again
+  static const CycleAction cycleAction(const bool imminent_coll, const bool coll, bool& watchdog_coll, bool& notify);
+
 
 
   /** Data Members **/
@@ -35,25 +95,46 @@ class MobileRobot
   ros::Publisher                    pub_twist_;
   ros::Publisher                    pub_cmd_vel_;
   ros::Publisher                    pub_update_;
+  ros::Publisher                    pub_watchdog_;
+  ros::Subscriber                   sub_trajectory_;
   ros::Subscriber                   sub_odometry_;
   ros::Subscriber                   sub_imminent_collision_;
+  ros::Subscriber                   sub_obstacles_;
   ramp_msgs::MotionState            motion_state_; 
   geometry_msgs::Twist              velocity_;
   ramp_msgs::RampTrajectory         trajectory_;
   ros::Timer                        timer_;
   double                            initial_theta_;
+  double                            initial_x_;
+  double                            initial_y_;
+
+  // Gains of the tracking controller, all 0 follows the trajectory open loop
+  double                            k_x_;
+  double                            k_y_;
+  double                            k_theta_;
 
   bool                              check_imminent_coll_;
-  bool                              imminent_coll_;
+  boost::atomic<bool>               imminent_coll_;
   bool                              sim_;
 
+  // The watchdog checks the next watchdog_ticks_ control cycles of the plan against the obstacles
+  // and slows the robot down at watchdog_decel_ if they come within watchdog_dist_
+  bool                              watchdog_;
+  int                               watchdog_ticks_;
+  double                            watchdog_dist_;
+  double                            watchdog_decel_;
+
+  // Acceleration and jerk limits of the twists, set before startControl
+  CommandShaper                     shaper_;
+
   // static const members
   static const std::string  TOPIC_STR_PHIDGET_MOTOR;
   static const std::string  TOPIC_STR_ODOMETRY;
   static const std::string  TOPIC_STR_UPDATE;
   static const std::string  TOPIC_STR_TWIST;
   static const std::string  TOPIC_STR_IC;
-  static const int          ACCELERATION_CONSTANT = 50;
+  static const std::string  TOPIC_STR_OBSTACLES;
+  static const std::string  TOPIC_STR_WATCHDOG;
   
   std::vector<ros::Duration> t_points_;
   ros::Time t_prev_traj_;
@@ -63,30 +144,60 @@ class MobileRobot
   /** Methods **/
 
   void                        sendTwist() const;
-  void                        calculateSpeedsAndTime();
-  void                        printVectors() const;
+  void                        calculateSpeedsAndTime(ControlPlan& plan, const unsigned int i_start=0) const;
+  void                        printVectors(const ControlPlan& plan) const;
   const bool                  checkImminentCollision();
-  const std::vector<double>   computeAcceleration() const;
 
-  void                        accountForAcceleration();
+  // Replace the part of plan_ after the prefix it shares with msg, returns false if there is no shared prefix
+  const bool                  splice(const ramp_msgs::RampTrajectory& msg);
+
+  // Interpolate the plan at t seconds from its start, i is the index of the point before t
+  void                        getReference(const ControlPlan& plan, const int i, const double t, ControlReference& result) const;
+
+  // Twist that tracks ref from the latest odometry
+  void                        computeTwist(const ControlReference& ref, geometry_msgs::Twist& result) const;
+
+  // Returns true if the plan from point i and t seconds on comes too close to an obstacle
+  const bool                  checkWatchdog(const ControlPlan& plan, const int i, const double t, const ros::Time& now) const;
+
+  // Bring twist_ closer to 0 for a cycle of t seconds
+  void                        decelerate(const double t);
+
+  // Body of the control thread, calls moveOnTrajectory once per cycle
+  void                        controlLoop();
 
 
   /** Data Members **/
 
   Utility                   utility_;
-  bool                      restart_;
   int                       num_;
   int                       num_traveled_;
   const unsigned int        k_dof_;
-  std::vector<ros::Time>    end_times; 
-  std::vector<double>       speeds_linear_;
-  std::vector<double>       speeds_angular_;
-  std::vector<double>       orientations_;
+
+  // Written by the subscriber callbacks, read by the control thread
+  TripleBuffer<ControlPlan>             plans_;
+  TripleBuffer<StateEstimator>          states_;
+  TripleBuffer<WatchdogObstacles>       obstacles_;
+
+  // Last plan built by updateTrajectory, only used by the subscriber thread
+  ControlPlan                           plan_;
+
+  // Progress of the control thread, id 0 means it is not following a plan
+  boost::atomic<uint32_t>               active_plan_;
+  boost::atomic<double>                 t_active_plan_;
+  boost::atomic<int>                    num_traveled_active_plan_;
+
+  boost::thread             control_thread_;
+  boost::atomic<bool>       control_running_;
+  double                    control_rate_;
+  ros::Time                 t_prev_cycle_;
+  bool                      watchdog_coll_;
 
   geometry_msgs::Twist      twist_;
   geometry_msgs::Twist      zero_twist_;
-  ramp_msgs::MotionState    prev_motion_state_; 
-  ros::Time                 prev_t_;
+  // Odometry for the subscriber thread, and the state the control thread extrapolated for its cycle
+  StateEstimator            estimator_;
+  ramp_msgs::MotionState    ms_control_;
   ros::Duration             t_immiColl_;
 
 
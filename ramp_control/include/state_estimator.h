@@ -0,0 +1,47 @@
+#ifndef STATE_ESTIMATOR_H
+#define STATE_ESTIMATOR_H
+
+#include "ros/ros.h"
+#include "nav_msgs/Odometry.h"
+#include "tf/transform_datatypes.h"
+#include "ramp_msgs/MotionState.h"
+
+// Longest time a state is extrapolated past the last odometry
+#define MAX_EXTRAPOLATION 0.5
+
+// Weight of a new acceleration measurement in the filtered acceleration
+#define ACCELERATION_FILTER 0.5
+
+
+/**
+ * Keeps the latest odometry with its time and predicts the state at a later time
+ *
+ * States are in the odometry frame, velocities and accelerations are
+ * [linear.x, linear.y, angular.z] in the robot's frame like nav_msgs::Odometry.
+ * Accelerations are estimated from consecutive odometry messages.
+ * The estimator holds no pointers so it can be copied between threads.
+ */
+class StateEstimator {
+public:
+
+  StateEstimator();
+  ~StateEstimator();
+
+  // Add odometry, t is used when msg has no stamp
+  void update(const nav_msgs::Odometry& msg, const ros::Time& t);
+
+  // State extrapolated to time t with constant accelerations
+  void predict(const ros::Time& t, ramp_msgs::MotionState& result) const;
+
+  // State at the latest odometry
+  const ramp_msgs::MotionState& latest() const;
+  const ros::Time& latestTime() const;
+
+private:
+
+  ramp_msgs::MotionState  ms_;
+  ros::Time               t_;
+  bool                    initialized_;
+};
+
+#endif
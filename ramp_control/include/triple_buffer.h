@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <boost/atomic.hpp>
+
+/**
+ * Lock-free single producer, single consumer buffer
+ *
+ * The writer fills the back slot and publishes it by swapping it with the
+ * shared middle slot, the reader swaps the middle slot with its front slot
+ * when a new value was published. Neither side ever waits on the other and
+ * the reader always sees the most recent complete value. The third slot is
+ * what lets the writer publish twice while the reader is still using a value.
+ *
+ * Slots are reused, so a T holding vectors keeps its capacity between writes.
+ */
+template <class T>
+class TripleBuffer {
+public:
+
+  TripleBuffer() : back_(0), middle_(1), front_(2) {}
+
+  /** Slot to fill before calling publish, only the writer thread may use it */
+  T& write() { return slots_[back_]; }
+
+  /** Make the slot returned by write() the latest value */
+  void publish()
+  {
+    back_ = middle_.exchange(back_ | NEW_BIT, boost::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  /** Move to the latest published value, returns true if there was a new one */
+  const bool update()
+  {
+    if( !(middle_.load(boost::memory_order_relaxed) & NEW_BIT) )
+    {
+      return false;
+    }
+
+    front_ = middle_.exchange(front_, boost::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+
+  /** Value the reader is on, only the reader thread may use it */
+  const T& read() const { return slots_[front_]; }
+
+private:
+
+  static const int NEW_BIT    = 4;
+  static const int INDEX_MASK = 3;
+
+  T slots_[3];
+  int back_;
+  boost::atomic<int> middle_;
+  int front_;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <string>
 #include <sstream>
 #include <math.h>
+#include <boost/thread.hpp>
 #include "ramp_msgs/TrajectoryRequest.h"
 #include "ramp_msgs/TrajectoryResponse.h"
 #include "ramp_msgs/Range.h"
@@ -38,5 +39,8 @@ class Utility {
     const std::string toString(const ramp_msgs::Path p) const;
     const std::string toString(const ramp_msgs::MotionState c) const;
     const std::string toString(const ramp_msgs::KnotPoint kp) const;
+
+    // Run thread with SCHED_FIFO at priority, returns false if that is not allowed
+    const bool setRealTimePriority(boost::thread& thread, const int priority) const;
 };
 #endif
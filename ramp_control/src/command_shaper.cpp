@@ -0,0 +1,70 @@
+#include "command_shaper.h"
+
+CommandShaper::CommandShaper() : a_max_linear_(1.5), a_max_angular_(3.0), j_max_linear_(10), j_max_angular_(20),
+  v_linear_(0), v_angular_(0), a_linear_(0), a_angular_(0) {}
+
+CommandShaper::~CommandShaper() {}
+
+
+void CommandShaper::setLimits(const double a_linear, const double a_angular, const double j_linear, const double j_angular)
+{
+  a_max_linear_   = a_linear;
+  a_max_angular_  = a_angular;
+  j_max_linear_   = j_linear;
+  j_max_angular_  = j_angular;
+}
+
+
+
+/** The target of each axis is where the reference will be at the end of the cycle */
+void CommandShaper::shape(const geometry_msgs::Twist& desired, const double a_linear, const double a_angular, 
+    const double dt, geometry_msgs::Twist& result)
+{
+  result.linear.x   = shapeAxis(desired.linear.x + a_linear*dt, a_max_linear_, j_max_linear_, dt, v_linear_, a_linear_);
+  result.angular.z  = shapeAxis(desired.angular.z + a_angular*dt, a_max_angular_, j_max_angular_, dt, v_angular_, a_angular_);
+} // End shape
+
+
+
+void CommandShaper::reset(const geometry_msgs::Twist& twist)
+{
+  v_linear_   = twist.linear.x;
+  v_angular_  = twist.angular.z;
+  a_linear_   = 0;
+  a_angular_  = 0;
+}
+
+
+
+const double CommandShaper::shapeAxis(const double target, const double a_max, const double j_max, const double dt, double& v, double& a) const
+{
+  if(dt <= 0)
+  {
+    return v;
+  }
+
+  // Acceleration that reaches the target this cycle
+  double e      = target - v;
+  double a_des  = e / dt;
+
+  // With limited jerk, the acceleration must be small enough to ramp back to 0 before the target,
+  // counting this cycle and the cycles of the ramp down
+  if(j_max > 0)
+  {
+    double a_stop = j_max*( sqrt(2.25*dt*dt + 2.*fabs(e)/j_max) - 1.5*dt );
+    a_des = a_des > a_stop ? a_stop : a_des < -a_stop ? -a_stop : a_des;
+  }
+
+  a_des = a_des > a_max ? a_max : a_des < -a_max ? -a_max : a_des;
+
+  if(j_max > 0)
+  {
+    double d_a = j_max*dt;
+    a_des = a_des > a+d_a ? a+d_a : a_des < a-d_a ? a-d_a : a_des;
+  }
+
+  a = a_des;
+  v += a*dt;
+
+  return v;
+} // End shapeAxis
@@ -0,0 +1,85 @@
+#include "control_wheel.h"
+
+ControlWheel::ControlWheel() : resolution_(0.005), slots_(WHEEL_SLOTS), tick_(0), num_robots_(0), running_(false) {}
+
+ControlWheel::~ControlWheel() 
+{
+  stop();
+}
+
+
+void ControlWheel::setResolution(const double resolution)
+{
+  resolution_ = resolution;
+}
+
+
+
+void ControlWheel::add(MobileRobot* robot, const double rate)
+{
+  Entry e;
+  e.robot   = robot;
+  e.period  = (unsigned int) (1. / (rate*resolution_) + 0.5);
+  if(e.period < 1)
+  {
+    e.period = 1;
+  }
+  else if(e.period >= WHEEL_SLOTS)
+  {
+    ROS_WARN("Control rate %f is too slow for the wheel, using %f", rate, 1. / ((WHEEL_SLOTS-1)*resolution_));
+    e.period = WHEEL_SLOTS-1;
+  }
+
+  // The robot runs at the rate the wheel can give it
+  robot->initControl(1. / (e.period*resolution_));
+
+  // Spread robots over the period
+  slots_.at( (tick_ + num_robots_ % e.period) % WHEEL_SLOTS ).push_back(e);
+  num_robots_++;
+} // End add
+
+
+
+void ControlWheel::start(const int priority)
+{
+  running_  = true;
+  thread_   = boost::thread(&ControlWheel::run, this);
+
+  if(priority > 0)
+  {
+    utility_.setRealTimePriority(thread_, priority);
+  }
+} // End start
+
+
+void ControlWheel::stop()
+{
+  running_ = false;
+  if(thread_.joinable())
+  {
+    thread_.join();
+  }
+} // End stop
+
+
+
+void ControlWheel::run()
+{
+  ros::WallRate r(1. / resolution_);
+
+  while(ros::ok() && running_)
+  {
+    // Take the robots that are due, the slot keeps due_'s memory for next time
+    due_.swap(slots_[tick_ % WHEEL_SLOTS]);
+
+    for(unsigned int i=0;i<due_.size();i++)
+    {
+      due_[i].robot->moveOnTrajectory();
+      slots_[(tick_ + due_[i].period) % WHEEL_SLOTS].push_back(due_[i]);
+    }
+    due_.clear();
+
+    tick_++;
+    r.sleep();
+  }
+} // End run
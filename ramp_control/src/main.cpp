@@ -1,74 +1,137 @@
 #include "ros/ros.h"
 #include <signal.h>
 #include "mobile_robot.h"
+#include "control_wheel.h"
 #include "ramp_msgs/MotionState.h"
 
-MobileRobot robot;
-
-void trajCallback(const ramp_msgs::RampTrajectory::ConstPtr& msg) {
-  //std::cout<<"\nGot the trajectory message!\n";
-  //std::cout<<"\nPress enter to call updateTrajectory\n";
-  //std::cin.get();
-  robot.updateTrajectory(*msg);
-}
-
-
-
+// One MobileRobot per robot namespace in ~robots, or one in the node's namespace
+std::vector<MobileRobot*> robots;
+ControlWheel wheel;
 
 
 
 /** Initialize the MobileRobot's publishers and subscibers*/
-void init_advertisers_subscribers(MobileRobot& robot, ros::NodeHandle& handle, bool simulation) 
+void init_advertisers_subscribers(MobileRobot& robot, ros::NodeHandle& handle, bool simulation, double update_rate) 
 {
 
   
   // Publishers
   robot.pub_twist_ = handle.advertise<geometry_msgs::Twist>(MobileRobot::TOPIC_STR_TWIST, 1000);
   robot.pub_update_ = handle.advertise<ramp_msgs::MotionState>(MobileRobot::TOPIC_STR_UPDATE, 1000);
+  robot.pub_watchdog_ = handle.advertise<std_msgs::Bool>(MobileRobot::TOPIC_STR_WATCHDOG, 10);
 
   if(simulation) {
     robot.pub_cmd_vel_ = handle.advertise<geometry_msgs::Twist>("cmd_vel", 10);
   }
  
   // Subscribers
+  robot.sub_trajectory_ = handle.subscribe("bestTrajec", 1, &MobileRobot::updateTrajectory, &robot);
   robot.sub_odometry_ = handle.subscribe(MobileRobot::TOPIC_STR_ODOMETRY, 1, &MobileRobot::odomCb, &robot);
   robot.sub_imminent_collision_ = handle.subscribe(MobileRobot::TOPIC_STR_IC, 1, &MobileRobot::imminentCollisionCb, &robot);
+  if(robot.watchdog_)
+  {
+    robot.sub_obstacles_ = handle.subscribe(MobileRobot::TOPIC_STR_OBSTACLES, 1, &MobileRobot::obstaclesCb, &robot);
+  }
 
   // Timers
-  // 15 Hz seems to be the fastest possible while avoiding nan errors
-  robot.timer_ = handle.createTimer(ros::Duration(1.f / 30.f), &MobileRobot::updateCallback, &robot);
+  // The state is extrapolated from odometry when it is sent, so it can be sent faster than odometry arrives
+  robot.timer_ = handle.createTimer(ros::Duration(1.f / update_rate), &MobileRobot::updateCallback, &robot);
 } // End init_advertisers_subscribers
 
 
 
 void reportData(int sig)
 {
-  double sum = 0;
-  for(int i=0;i<robot.t_points_.size();i++)
+  for(unsigned int r=0;r<robots.size();r++)
   {
-    sum += robot.t_points_[i].toSec();
+    double sum = 0;
+    for(int i=0;i<robots[r]->t_points_.size();i++)
+    {
+      sum += robots[r]->t_points_[i].toSec();
+    }
+    ROS_INFO("Average point time: %f", (sum / robots[r]->t_points_.size()));
   }
-  ROS_INFO("Average point time: %f", (sum / robot.t_points_.size()));
 }
 
 
 
-/*void readParam(ros::NodeHandle& handle)
+/** Get a private parameter for the robot in ns, ~ns/name if it is set and ~name otherwise */
+template <class T>
+void getRobotParam(const ros::NodeHandle& handle_local, const std::string& ns, const std::string& name, T& value, const T& default_value)
 {
-  handle_local.param("orientation", robot.initial_theta_, 0.);
+  if(ns.size() == 0 || !handle_local.getParam(ns + "/" + name, value))
+  {
+    handle_local.param(name, value, default_value);
+  }
+}
+
+
+
+/** Read the parameters of the robot in namespace ns, and set up its topics in that namespace */
+void initRobot(MobileRobot& robot, const std::string& ns, ros::NodeHandle& handle_local) 
+{
+  ros::NodeHandle handle(ns);
+  ROS_INFO("Robot namespace: %s", handle.getNamespace().c_str());
+
+  //handle.param("ramp_control/orientation", robot.initial_theta_, 0.785);
+  getRobotParam(handle_local, ns, "orientation", robot.initial_theta_, -0.785);
   std::cout<<"\n*********robot.orientation: "<<robot.initial_theta_;
-  
+
   bool sim=false;
-  handle_local.param("simulation", sim, true);
+  getRobotParam(handle_local, ns, "simulation", sim, true);
   std::cout<<"\nsim: "<<sim<<"\n";
   robot.sim_ = sim;
  
  
   bool check_imminent_coll=true;
-  handle_local.param("check_imminent_coll", check_imminent_coll, true);
+  getRobotParam(handle_local, ns, "check_imminent_coll", check_imminent_coll, true);
   ROS_INFO("check_imminent_coll: %s", check_imminent_coll ? "True" : "False");
   robot.check_imminent_coll_ = check_imminent_coll;
-}*/
+
+  // Odometry starts at the robot's start position, the same transform the planner uses
+  std::vector<double> start;
+  if(handle.getParam("robot_info/start", start) && start.size() > 1)
+  {
+    robot.initial_x_ = start.at(0);
+    robot.initial_y_ = start.at(1);
+  }
+  else
+  {
+    ROS_WARN("Could not get robot_info/start, using (0, 0) as the start position");
+  }
+
+  getRobotParam(handle_local, ns, "k_x", robot.k_x_, 1.);
+  getRobotParam(handle_local, ns, "k_y", robot.k_y_, 3.);
+  getRobotParam(handle_local, ns, "k_theta", robot.k_theta_, 2.);
+  ROS_INFO("Tracking gains k_x: %f k_y: %f k_theta: %f", robot.k_x_, robot.k_y_, robot.k_theta_);
+
+  getRobotParam(handle_local, ns, "watchdog", robot.watchdog_, true);
+  getRobotParam(handle_local, ns, "watchdog_ticks", robot.watchdog_ticks_, 25);
+  getRobotParam(handle_local, ns, "watchdog_dist", robot.watchdog_dist_, 0.4);
+  getRobotParam(handle_local, ns, "watchdog_decel", robot.watchdog_decel_, 1.0);
+  ROS_INFO("watchdog: %s ticks: %i dist: %f decel: %f", robot.watchdog_ ? "True" : "False", 
+      robot.watchdog_ticks_, robot.watchdog_dist_, robot.watchdog_decel_);
+
+  double max_accel_linear, max_accel_angular, max_jerk_linear, max_jerk_angular;
+  getRobotParam(handle_local, ns, "max_accel_linear", max_accel_linear, 1.5);
+  getRobotParam(handle_local, ns, "max_accel_angular", max_accel_angular, 3.0);
+  getRobotParam(handle_local, ns, "max_jerk_linear", max_jerk_linear, 10.0);
+  getRobotParam(handle_local, ns, "max_jerk_angular", max_jerk_angular, 20.0);
+  ROS_INFO("Acceleration limits: %f %f jerk limits: %f %f", max_accel_linear, max_accel_angular, max_jerk_linear, max_jerk_angular);
+  robot.shaper_.setLimits(max_accel_linear, max_accel_angular, max_jerk_linear, max_jerk_angular);
+
+  double update_rate;
+  getRobotParam(handle_local, ns, "update_rate", update_rate, 50.);
+  ROS_INFO("update_rate: %f", update_rate);
+
+  // Initialize publishers and subscribers
+  init_advertisers_subscribers(robot, handle, sim, update_rate);
+
+
+  // Make a blank ramp_msgs::RampTrajectory
+  ramp_msgs::RampTrajectory init;
+  robot.trajectory_ = init;
+} // End initRobot
 
 
 
@@ -80,46 +143,59 @@ int main(int argc, char** argv) {
   ros::NodeHandle handle;  
   ros::NodeHandle handle_local("~");
 
-  ros::Subscriber sub_traj = handle.subscribe("bestTrajec", 1, trajCallback);
-
   setvbuf(stdout, NULL, _IOLBF, 4096);
- 
-  //handle.param("ramp_control/orientation", robot.initial_theta_, 0.785);
-  handle_local.param("orientation", robot.initial_theta_, -0.785);
-  std::cout<<"\n*********robot.orientation: "<<robot.initial_theta_;
-
-  bool sim=false;
-  handle_local.param("simulation", sim, true);
-  std::cout<<"\nsim: "<<sim<<"\n";
-  robot.sim_ = sim;
- 
- 
-  bool check_imminent_coll=true;
-  handle_local.param("check_imminent_coll", check_imminent_coll, true);
-  ROS_INFO("check_imminent_coll: %s", check_imminent_coll ? "True" : "False");
-  robot.check_imminent_coll_ = check_imminent_coll;
-
-  // Initialize publishers and subscribers
-  init_advertisers_subscribers(robot, handle, sim);
 
+  // Namespaces of the robots this node controls, relative to the node's namespace
+  std::vector<std::string> namespaces;
+  handle_local.getParam("robots", namespaces);
+  if(namespaces.size() == 0)
+  {
+    namespaces.push_back("");
+  }
 
-  // Make a blank ramp_msgs::RampTrajectory
-  ramp_msgs::RampTrajectory init;
-  robot.trajectory_ = init;
+  for(unsigned int i=0;i<namespaces.size();i++)
+  {
+    robots.push_back(new MobileRobot());
+    initRobot(*robots.back(), namespaces.at(i), handle_local);
+  }
   
   signal(SIGINT, reportData);
 
-  // Put a rate on the while loop to prevent high CPU usage
-  // With no rate, CPU usage is ~110%
-  // With rate even as high as 1000, goes down to ~10-15%
-  // Shouldn't have problem moving right away on a trajectory with 1000Hz as the rate
-  ros::Rate r(1000);
-  while(ros::ok()) 
+  // Twists are sent from their own thread so callbacks never delay them
+  // A priority > 0 runs the thread with SCHED_FIFO (needs permission to do so)
+  double control_rate;
+  int control_priority;
+  handle_local.param("control_rate", control_rate, 50.);
+  handle_local.param("control_priority", control_priority, 0);
+  ROS_INFO("control_rate: %f control_priority: %i", control_rate, control_priority);
+
+  // A single robot gets its own thread, several share one wheel
+  if(robots.size() == 1)
+  {
+    robots.at(0)->startControl(control_rate, control_priority);
+  }
+  else
+  {
+    double resolution;
+    handle_local.param("wheel_resolution", resolution, 0.005);
+    ROS_INFO("Cycling %i robots on a wheel with resolution %f", (int)robots.size(), resolution);
+    wheel.setResolution(resolution);
+    for(unsigned int i=0;i<robots.size();i++)
+    {
+      wheel.add(robots.at(i), control_rate);
+    }
+    wheel.start(control_priority);
+  }
+
+  ros::spin();
+
+  wheel.stop();
+  for(unsigned int i=0;i<robots.size();i++)
   {
-    robot.moveOnTrajectory();
-    r.sleep();
-    ros::spinOnce();
+    robots.at(i)->stopControl();
+    delete robots.at(i);
   }
+  robots.clear();
 
   fflush(stdout);
 
@@ -6,13 +6,24 @@ const std::string MobileRobot::TOPIC_STR_ODOMETRY="odometry";
 const std::string MobileRobot::TOPIC_STR_UPDATE="update";
 const std::string MobileRobot::TOPIC_STR_TWIST="twist";
 const std::string MobileRobot::TOPIC_STR_IC="imminent_collision";
+const std::string MobileRobot::TOPIC_STR_OBSTACLES="obstacles";
+const std::string MobileRobot::TOPIC_STR_WATCHDOG="watchdog_collision";
 const float BASE_WIDTH=0.2413;
 
 const float timeNeededToTurn = 2.5; 
 
+// How close a new trajectory must be to the active one to be spliced in
+const float SPLICE_TIME_TOLERANCE     = 0.1;
+const float SPLICE_POSITION_TOLERANCE = 0.05;
+const float SPLICE_ANGLE_TOLERANCE    = 0.1;
 
+// Limits on the tracking controller's output
+const float MAX_SPEED_LINEAR  = 0.5;
+const float MAX_SPEED_ANGULAR = 2.0;
 
-MobileRobot::MobileRobot() : restart_(false), num_(0), num_traveled_(0), k_dof_(3)  
+
+
+MobileRobot::MobileRobot() : initial_x_(0), initial_y_(0), k_x_(1), k_y_(3), k_theta_(2), imminent_coll_(false), watchdog_(true), watchdog_ticks_(25), watchdog_dist_(0.4), watchdog_decel_(1.0), num_(0), num_traveled_(0), k_dof_(3), active_plan_(0), t_active_plan_(0), num_traveled_active_plan_(0), control_running_(false), control_rate_(50), watchdog_coll_(false)  
 { 
   for(unsigned int i=0;i<k_dof_;i++)
   {
@@ -22,8 +33,11 @@ MobileRobot::MobileRobot() : restart_(false), num_(0), num_traveled_(0), k_dof_(
     motion_state_.jerks.push_back(0);
   }
 
-  prev_motion_state_ = motion_state_;
+  // The control thread reads the state before any odometry arrives
+  states_.write() = estimator_;
+  states_.publish();
 
+  plan_.id = 0;
 
   zero_twist_.linear.x = 0.;
   zero_twist_.angular.z = 0.;
@@ -31,68 +45,77 @@ MobileRobot::MobileRobot() : restart_(false), num_(0), num_traveled_(0), k_dof_(
 
 
 MobileRobot::~MobileRobot() 
-{}
+{
+  stopControl();
+}
 
 
 
+/** Set up for moveOnTrajectory to be called rate times per second, starting now */
+void MobileRobot::initControl(const double rate)
+{
+  control_rate_   = rate;
+  t_prev_cycle_   = ros::Time::now();
+} // End initControl
 
 
+/** Start the control thread, it calls moveOnTrajectory rate times per second */
+void MobileRobot::startControl(const double rate, const int priority)
+{
+  initControl(rate);
+  control_running_  = true;
+  control_thread_   = boost::thread(&MobileRobot::controlLoop, this);
 
+  if(priority > 0)
+  {
+    utility_.setRealTimePriority(control_thread_, priority);
+  }
+} // End startControl
 
-/*
- * Computes acceleration manually
- */
-const std::vector<double> MobileRobot::computeAcceleration() const 
+
+void MobileRobot::stopControl()
+{
+  control_running_ = false;
+  if(control_thread_.joinable())
+  {
+    control_thread_.join();
+  }
+} // End stopControl
+
+
+void MobileRobot::controlLoop()
 {
-  std::vector<double> result;
+  ros::WallRate r(control_rate_);
 
-  for(unsigned int i=0;i<k_dof_;i++) 
+  while(ros::ok() && control_running_)
   {
-    double a = (motion_state_.velocities.at(i) - prev_motion_state_.velocities.at(i)) 
-              / (ros::Time::now() - prev_t_).toSec();
-    result.push_back(a);
+    moveOnTrajectory();
+    r.sleep();
   }
+} // End controlLoop
+
+
+
+
+
 
-  return result;
-}
 
 /* 
  * This is a callback for receiving odometry from the robot and sets the configuration of the robot 
- * It does not mutate any motion data. The time value is added based on num_travaled_.
+ * It does not mutate any motion data. The time value is added based on the control thread's progress.
  */
 void MobileRobot::odomCb(const nav_msgs::Odometry& msg) {
   //ROS_INFO("Received odometry update!");
- 
-  prev_motion_state_ = motion_state_;
 
-  // Clear position and velocity vectors
-  motion_state_.positions.clear();
-  motion_state_.velocities.clear();
-  motion_state_.accelerations.clear();
-  
-  // Set latest positions
-  motion_state_.positions.push_back(msg.pose.pose.position.x);
-  motion_state_.positions.push_back(msg.pose.pose.position.y);
-  motion_state_.positions.push_back(tf::getYaw(msg.pose.pose.orientation));
-
-  // Set latest velocities
-  motion_state_.velocities.push_back(msg.twist.twist.linear.x);
-  motion_state_.velocities.push_back(msg.twist.twist.linear.y);
-  motion_state_.velocities.push_back(msg.twist.twist.angular.z);
-
-  // Odometry does not have acceleration info, but
-  // it would be pushed on here
-  std::vector<double> a = computeAcceleration();
-  for(unsigned int i=0;i<a.size();i++) 
-  {
-    motion_state_.accelerations.push_back(a.at(i));
-  }
+  estimator_.update(msg, ros::Time::now());
 
-  motion_state_.time = num_traveled_ * CYCLE_TIME_IN_SECONDS;
+  motion_state_       = estimator_.latest();
+  motion_state_.time  = num_traveled_active_plan_ * CYCLE_TIME_IN_SECONDS;
   
   //ROS_INFO("Motion state: %s", utility_.toString(motion_state_).c_str());
-    
-  prev_t_ = ros::Time::now();
+
+  states_.write() = estimator_;
+  states_.publish();
 } // End updateState
 
 
@@ -104,15 +127,46 @@ void MobileRobot::imminentCollisionCb(const std_msgs::Bool msg)
 }
 
 
+/** Keep the latest obstacles for the watchdog, they move in the direction they face as in the planner's prediction */
+void MobileRobot::obstaclesCb(const ramp_msgs::ObstacleList& msg)
+{
+  WatchdogObstacles& obs = obstacles_.write();
+  obs.t_received = ros::Time::now();
+  obs.x.clear();
+  obs.y.clear();
+  obs.v_x.clear();
+  obs.v_y.clear();
+
+  for(unsigned int i=0;i<msg.obstacles.size();i++)
+  {
+    const ramp_msgs::MotionState& ms = msg.obstacles.at(i).ob_ms;
+    double v = sqrt( pow(ms.velocities.at(0), 2) + pow(ms.velocities.at(1), 2) );
+
+    obs.x.push_back(ms.positions.at(0));
+    obs.y.push_back(ms.positions.at(1));
+    obs.v_x.push_back(v*cos(ms.positions.at(2)));
+    obs.v_y.push_back(v*sin(ms.positions.at(2)));
+  }
+
+  obstacles_.publish();
+} // End obstaclesCb
+
 
-/** This method is on a timer to publish the robot's latest configuration */
+
+/** 
+ * This method is on a timer to publish the robot's configuration, 
+ * extrapolated from the latest odometry to the time it is sent 
+ */
 void MobileRobot::updateCallback(const ros::TimerEvent& e) {
   //ROS_INFO("Publishing latest MotionState");
   //std::cout<<"\nIn updatePublishTimer\n";
   
   if (pub_update_) 
   {
-      pub_update_.publish(motion_state_);
+      ramp_msgs::MotionState ms;
+      estimator_.predict(ros::Time::now(), ms);
+      ms.time = motion_state_.time;
+      pub_update_.publish(ms);
       //ROS_INFO("Motion state: %s", utility_.toString(motion_state_).c_str());
   }
 } // End updatePublishTimer
@@ -120,7 +174,8 @@ void MobileRobot::updateCallback(const ros::TimerEvent& e) {
 
 
 /** This method updates the MobileRobot's trajectory
- *   It calls calculateSpeedsAndTimes to update the robot's vectors needed to move */
+ *   It splices msg into the active plan or calls calculateSpeedsAndTimes to build a new one, 
+ *   the control thread switches to it on its next cycle */
 void MobileRobot::updateTrajectory(const ramp_msgs::RampTrajectory& msg) 
 {
   //ROS_INFO("Time since last trajectory: %f", (ros::Time::now() - t_prev_traj_).toSec());
@@ -135,28 +190,24 @@ void MobileRobot::updateTrajectory(const ramp_msgs::RampTrajectory& msg)
   }
   ROS_INFO("Average point time: %f", (sum / t_points_.size()));*/
   
-  // Update data members
-  restart_        = true;
-  num_traveled_   = 1;
-  trajectory_     = msg;
-  num_            = trajectory_.trajectory.points.size();
-  t_immiColl_     = ros::Duration(0);
-  
-  // Update vectors for speeds and times
-  if(trajectory_.trajectory.points.size() > 0) 
+  trajectory_ = msg;
+
+  // Fill the plan's vectors for speeds and times, an empty plan stops the robot
+  if(!splice(msg))
   {
-    calculateSpeedsAndTime();
+    plan_.trajectory  = msg;
+    plan_.spliced     = false;
+    calculateSpeedsAndTime(plan_);
   }
-  else 
+  plan_.id++;
+  if(plan_.id == 0)
   {
-    ROS_INFO("Stopping at state: %s", utility_.toString(motion_state_).c_str());
-    twist_.linear.x = 0;
-    twist_.angular.z = 0;
-    sendTwist();
-    sendTwist();
-    sendTwist();
+    plan_.id++;
   }
 
+  plans_.write() = plan_;
+  plans_.publish();
+
   //if(trajectory_.trajectory.points.size() > 2)
     //ROS_INFO("Moving on: %s", utility_.toString(trajectory_).c_str());
 } // End updateTrajectory
@@ -164,66 +215,128 @@ void MobileRobot::updateTrajectory(const ramp_msgs::RampTrajectory& msg)
 
 
 
-void MobileRobot::accountForAcceleration() {
-  std::vector<double> v;
-  for(int i=0;i<num_-1;i++) {
-    // Get the next points on the trajectory
-    trajectory_msgs::JointTrajectoryPoint current = trajectory_.trajectory.points.at(i);
-    trajectory_msgs::JointTrajectoryPoint next    = trajectory_.trajectory.points.at(i+1);
+/** 
+ * If the control thread is on plan_ and msg starts where it is on plan_, with the
+ * same times and positions for some points, keep plan_'s points up to the end of 
+ * that shared prefix and append the rest of msg. plan_'s start time is kept so 
+ * the control thread carries on without a jump in its reference
+ */
+const bool MobileRobot::splice(const ramp_msgs::RampTrajectory& msg)
+{
+  const std::vector<trajectory_msgs::JointTrajectoryPoint>& points_new = msg.trajectory.points;
+  std::vector<trajectory_msgs::JointTrajectoryPoint>& points = plan_.trajectory.trajectory.points;
+
+  if(plan_.id == 0 || active_plan_ != plan_.id || points_new.size() < 2 || points.size() < 2)
+  {
+    return false;
   }
-}
 
+  // Find the point of plan_ the new trajectory starts at
+  double t = t_active_plan_;
+  unsigned int j=0;
+  while(j+1 < points.size() && plan_.times.at(j+1) <= t)
+  {
+    j++;
+  }
+  if(j+1 < points.size() && (plan_.times.at(j+1) - t) < (t - plan_.times.at(j)))
+  {
+    j++;
+  }
+  if(fabs(plan_.times.at(j) - t) > SPLICE_TIME_TOLERANCE)
+  {
+    return false;
+  }
 
+  // Count the points that match
+  double t_offset = plan_.times.at(j) - points_new.at(0).time_from_start.toSec();
+  unsigned int m=0;
+  while(m < points_new.size() && j+m < points.size())
+  {
+    const trajectory_msgs::JointTrajectoryPoint& a = points.at(j+m);
+    const trajectory_msgs::JointTrajectoryPoint& b = points_new.at(m);
 
-/** 
- * Calculate all the necessary values to move the robot: the linear and angular velocities as well as ending times
- * This method sets the vectors speeds, orientations, and end_times
- **/
-void MobileRobot::calculateSpeedsAndTime () {
-  speeds_linear_.clear();
-  speeds_angular_.clear();
-  end_times.clear();
-  orientations_.clear();
-  
+    if(fabs(a.time_from_start.toSec() - (b.time_from_start.toSec() + t_offset)) > 0.001 ||
+        fabs(a.positions.at(0) - b.positions.at(0)) > SPLICE_POSITION_TOLERANCE ||
+        fabs(a.positions.at(1) - b.positions.at(1)) > SPLICE_POSITION_TOLERANCE ||
+        fabs(utility_.findDistanceBetweenAngles(a.positions.at(2), b.positions.at(2))) > SPLICE_ANGLE_TOLERANCE)
+    {
+      break;
+    }
+    m++;
+  }
 
-  // Get the starting time
-  ros::Time start_time = ros::Time::now();
+  // The robot needs at least the segment it is on
+  if(m < 2)
+  {
+    return false;
+  }
+  //ROS_INFO("Splicing at point %i, %i shared points, %i new points", j, m, (int)(points_new.size() - m));
 
+  // Replace everything after the shared prefix
+  unsigned int i_start = j+m;
+  points.resize(i_start);
+  for(unsigned int i=m;i<points_new.size();i++)
+  {
+    points.push_back(points_new.at(i));
+    points.back().time_from_start += ros::Duration(t_offset);
+  }
 
+  plan_.spliced = true;
+  calculateSpeedsAndTime(plan_, i_start);
 
-  // Go through all the points of the received trajectory
-  for(int i=0;i<num_-1;i++) 
-  {
-    if(i >= trajectory_.trajectory.points.size()-1)
-    {
-      ROS_ERROR("i: %i trajectory.size(): %i", i, (int)trajectory_.trajectory.points.size());
-    }
-    trajectory_msgs::JointTrajectoryPoint current = trajectory_.trajectory.points.at(i);
-    trajectory_msgs::JointTrajectoryPoint next    = trajectory_.trajectory.points.at(i+1);
-    /*std::cout<<"\nPoint "<<i;
-    std::cout<<"\nCurrent: "<<utility_.toString(current);
-    std::cout<<"\nnext: "<<utility_.toString(next);*/
+  return true;
+} // End splice
 
-    //double vx = (next.positions.at(0) - current.positions.at(0)) / 0.1;
-    //double vy = (next.positions.at(1) - current.positions.at(1)) / 0.1;
-    double vx = next.velocities.at(0);
-    double vy = next.velocities.at(1);
 
-    speeds_linear_.push_back( sqrt( pow(vx,2)
-                                  + pow(vy,2) ));
 
-    double w = utility_.findDistanceBetweenAngles(current.positions.at(2), next.positions.at(2)) / 0.1;
-    speeds_angular_.push_back( w ); 
 
-    //ROS_INFO("t: %f v: %f vx: %f vy: %f w: %f", current.time_from_start.toSec(), sqrt(vx*vx+vy*vy), vx, vy, w);
-    
-    end_times.push_back(start_time + next.time_from_start);
+/** 
+ * Calculate all the necessary values to move the robot: the time, linear and angular velocity and acceleration of each point
+ * The control thread interpolates between them, times are in seconds from plan.t_start
+ * Only the points from i_start on are computed, the start time is only set when i_start is 0
+ **/
+void MobileRobot::calculateSpeedsAndTime(ControlPlan& plan, const unsigned int i_start) const {
+  const ramp_msgs::RampTrajectory& trajectory = plan.trajectory;
+
+  plan.times.resize(i_start);
+  plan.speeds_linear.resize(i_start);
+  plan.speeds_angular.resize(i_start);
+  plan.accelerations_linear.resize(i_start);
+  plan.accelerations_angular.resize(i_start);
 
-    orientations_.push_back( utility_.findAngleFromAToB(current.positions, next.positions) ); 
+  // Get the starting time
+  if(i_start == 0)
+  {
+    plan.t_start = ros::Time::now();
   }
 
+  // Go through all the new points of the received trajectory
+  for(unsigned int i=i_start;i<trajectory.trajectory.points.size();i++) 
+  {
+    const trajectory_msgs::JointTrajectoryPoint& p = trajectory.trajectory.points.at(i);
+
+    double vx = p.velocities.at(0);
+    double vy = p.velocities.at(1);
+
+    plan.times.push_back(p.time_from_start.toSec());
+    plan.speeds_linear.push_back( sqrt( pow(vx,2)
+                                      + pow(vy,2) ));
+    plan.speeds_angular.push_back(p.velocities.at(2));
+
+    // Linear acceleration is along the velocity, from rest it is all forward
+    double a_linear = 0, a_angular = 0;
+    if(p.accelerations.size() > 2)
+    {
+      double v = plan.speeds_linear.back();
+      a_linear  = v > 0.001 ? (vx*p.accelerations.at(0) + vy*p.accelerations.at(1)) / v 
+                            : sqrt( pow(p.accelerations.at(0),2) + pow(p.accelerations.at(1),2) );
+      a_angular = p.accelerations.at(2);
+    }
+    plan.accelerations_linear.push_back(a_linear);
+    plan.accelerations_angular.push_back(a_angular);
+  }
 
-  //printVectors();
+  //printVectors(plan);
 } // End calculateSpeedsAndTime
 
 
@@ -259,40 +372,36 @@ void MobileRobot::sendTwist(const geometry_msgs::Twist t) const
 
 
 /** This method prints out the information vectors */
-void MobileRobot::printVectors() const 
+void MobileRobot::printVectors(const ControlPlan& plan) const 
 {
+  if(plan.times.size() == 0)
+  {
+    return;
+  }
     
-  std::cout<<"\nspeeds_linear size: "<<speeds_linear_.size();
+  std::cout<<"\nspeeds_linear size: "<<plan.speeds_linear.size();
   std::cout<<"\nspeeds_linear: [";
-  for(unsigned int i=0;i<speeds_linear_.size()-1;i++) 
+  for(unsigned int i=0;i<plan.speeds_linear.size()-1;i++) 
   {
-    std::cout<<speeds_linear_.at(i)<<", ";
+    std::cout<<plan.speeds_linear.at(i)<<", ";
   }
-  std::cout<<speeds_linear_.at(speeds_linear_.size()-1)<<"]";
+  std::cout<<plan.speeds_linear.at(plan.speeds_linear.size()-1)<<"]";
   
-  std::cout<<"\nspeeds_angular size: "<<speeds_angular_.size();
-  std::cout<<"\nspeeds_angular_: [";
-  for(unsigned int i=0;i<speeds_angular_.size()-1;i++) 
-  {
-    std::cout<<speeds_angular_.at(i)<<", ";
-  }
-  std::cout<<speeds_angular_.at(speeds_angular_.size()-1)<<"]";
-
-  std::cout<<"\nend_times size: "<<end_times.size();
-  std::cout<<"\nend_times: [";
-  for(unsigned int i=0;i<end_times.size()-1;i++) 
+  std::cout<<"\nspeeds_angular size: "<<plan.speeds_angular.size();
+  std::cout<<"\nspeeds_angular: [";
+  for(unsigned int i=0;i<plan.speeds_angular.size()-1;i++) 
   {
-    std::cout<<end_times.at(i)<<", ";
+    std::cout<<plan.speeds_angular.at(i)<<", ";
   }
-  std::cout<<end_times.at(end_times.size()-1)<<"]";
+  std::cout<<plan.speeds_angular.at(plan.speeds_angular.size()-1)<<"]";
 
-  std::cout<<"\norientations_ size: "<<orientations_.size();
-  std::cout<<"\norientations_: [";
-  for(unsigned int i=0;i<orientations_.size()-1;i++) 
+  std::cout<<"\ntimes size: "<<plan.times.size();
+  std::cout<<"\ntimes: [";
+  for(unsigned int i=0;i<plan.times.size()-1;i++) 
   {
-    std::cout<<orientations_.at(i)<<", ";
+    std::cout<<plan.times.at(i)<<", ";
   }
-  std::cout<<orientations_.at(orientations_.size()-1)<<"]";
+  std::cout<<plan.times.at(plan.times.size()-1)<<"]";
 } // End printVectors
 
 
@@ -315,115 +424,259 @@ const bool MobileRobot::checkImminentCollision()
 
 
 
-/** This method moves the robot along trajectory_ */
-void MobileRobot::moveOnTrajectory() 
+/** 
+ * Interpolate the reference between points i and i+1 of the plan 
+ * Velocities are interpolated linearly, which is constant acceleration between the points
+ */
+void MobileRobot::getReference(const ControlPlan& plan, const int i, const double t, ControlReference& result) const
 {
-  restart_ = false;
-  ros::Rate r(20);
-  ros::Rate r_ic(100);
+  const trajectory_msgs::JointTrajectoryPoint& a = plan.trajectory.trajectory.points.at(i);
+  const trajectory_msgs::JointTrajectoryPoint& b = plan.trajectory.trajectory.points.at(i+1);
 
-  ros::Time s;
+  double dt = plan.times.at(i+1) - plan.times.at(i);
+  double s  = dt > 0 ? (t - plan.times.at(i)) / dt : 1;
+  s = s < 0 ? 0 : s > 1 ? 1 : s;
 
-  double actual_theta, dist;
+  result.x      = a.positions.at(0) + s*(b.positions.at(0) - a.positions.at(0));
+  result.y      = a.positions.at(1) + s*(b.positions.at(1) - a.positions.at(1));
+  result.theta  = utility_.displaceAngle(a.positions.at(2), 
+      s*utility_.findDistanceBetweenAngles(a.positions.at(2), b.positions.at(2)));
+  result.v      = plan.speeds_linear.at(i) + s*(plan.speeds_linear.at(i+1) - plan.speeds_linear.at(i));
+  result.w      = plan.speeds_angular.at(i) + s*(plan.speeds_angular.at(i+1) - plan.speeds_angular.at(i));
+  result.a_v    = plan.accelerations_linear.at(i) + s*(plan.accelerations_linear.at(i+1) - plan.accelerations_linear.at(i));
+  result.a_w    = plan.accelerations_angular.at(i) + s*(plan.accelerations_angular.at(i+1) - plan.accelerations_angular.at(i));
+} // End getReference
 
-  // Execute the trajectory
-  while(ros::ok() && (num_traveled_+1) < num_) 
+
+
+/** 
+ * Kanayama tracking controller: the reference speeds plus feedback on the
+ * pose error in the robot's frame. Odometry starts at (initial_x_, initial_y_, initial_theta_) 
+ * in the world frame
+ */
+void MobileRobot::computeTwist(const ControlReference& ref, geometry_msgs::Twist& result) const
+{
+  const ramp_msgs::MotionState& ms = ms_control_;
+
+  // Robot pose in the world frame
+  double c = cos(initial_theta_), s = sin(initial_theta_);
+  double x      = initial_x_ + c*ms.positions.at(0) - s*ms.positions.at(1);
+  double y      = initial_y_ + s*ms.positions.at(0) + c*ms.positions.at(1);
+  double theta  = utility_.displaceAngle(initial_theta_, ms.positions.at(2));
+
+  // Error in the robot's frame
+  double e_x      =  cos(theta)*(ref.x - x) + sin(theta)*(ref.y - y);
+  double e_y      = -sin(theta)*(ref.x - x) + cos(theta)*(ref.y - y);
+  double e_theta  = utility_.findDistanceBetweenAngles(theta, ref.theta);
+
+  double v = ref.v*cos(e_theta) + k_x_*e_x;
+  double w = ref.w + ref.v*(k_y_*e_y + k_theta_*sin(e_theta));
+
+  result.linear.x   = v > MAX_SPEED_LINEAR ? MAX_SPEED_LINEAR : v < -MAX_SPEED_LINEAR ? -MAX_SPEED_LINEAR : v;
+  result.angular.z  = w > MAX_SPEED_ANGULAR ? MAX_SPEED_ANGULAR : w < -MAX_SPEED_ANGULAR ? -MAX_SPEED_ANGULAR : w;
+  //ROS_INFO("e_x: %f e_y: %f e_theta: %f v: %f w: %f", e_x, e_y, e_theta, result.linear.x, result.angular.z);
+} // End computeTwist
+
+
+
+/** 
+ * Check the reference of the next watchdog_ticks_ control cycles against 
+ * the obstacles moved to the time of each cycle
+ */
+const bool MobileRobot::checkWatchdog(const ControlPlan& plan, const int i, const double t, const ros::Time& now) const
+{
+  const WatchdogObstacles& obs = obstacles_.read();
+  if(obs.x.size() == 0)
+  {
+    return false;
+  }
+
+  double t_obs  = (now - obs.t_received).toSec();
+  double dt     = 1. / control_rate_;
+  int j         = i;
+  ControlReference ref;
+  for(int k=0;k<=watchdog_ticks_;k++)
   {
-    //ROS_INFO("num_traveled_: %i/%i", num_traveled_, num_);
-    //ROS_INFO("At state: %s", utility_.toString(motion_state_).c_str());
-    s = ros::Time::now();
-    restart_ = false;
- 
-
-    // Force a stop until there is no imminent collision
-    if(check_imminent_coll_)
+    double t_k = t + k*dt;
+    while((j+2) < num_ && t_k >= plan.times.at(j+1))
     {
-      ros::Time t_startIC = ros::Time::now();
-      while(imminent_coll_ && ros::ok()) {
-        ROS_ERROR("Imminent Collision Exists, Stopping robot");
-        sendTwist(zero_twist_);
-        r_ic.sleep();
-        ros::spinOnce();
+      j++;
+    }
+    getReference(plan, j, t_k, ref);
+
+    for(unsigned int o=0;o<obs.x.size();o++)
+    {
+      double x = obs.x[o] + obs.v_x[o]*(t_obs + k*dt);
+      double y = obs.y[o] + obs.v_y[o]*(t_obs + k*dt);
+      if( pow(ref.x - x, 2) + pow(ref.y - y, 2) < watchdog_dist_*watchdog_dist_ )
+      {
+        return true;
       }
-      t_immiColl_ += ros::Time::now() - t_startIC;
     }
-    //ROS_INFO("t_immiColl_: %f", t_immiColl_.toSec());
+  }
 
-    
-    // If a new trajectory was received, restart the outer while 
-    if(restart_) 
+  return false;
+} // End checkWatchdog
+
+
+
+void MobileRobot::decelerate(const double t)
+{
+  double d = watchdog_decel_ * t;
+
+  twist_.linear.x   = fabs(twist_.linear.x) <= d ? 0 : twist_.linear.x > 0 ? twist_.linear.x - d : twist_.linear.x + d;
+  twist_.angular.z  = fabs(twist_.angular.z) <= d ? 0 : twist_.angular.z > 0 ? twist_.angular.z - d : twist_.angular.z + d;
+} // End decelerate
+
+
+
+/** 
+ * The watchdog state is updated on every cycle, also the ones held by an
+ * imminent collision. The planner raises the imminent collision for as long
+ * as the watchdog reports one, so it has to hear when it clears
+ */
+const CycleAction MobileRobot::cycleAction(const bool imminent_coll, const bool coll, bool& watchdog_coll, bool& notify)
+{
+  notify        = coll != watchdog_coll;
+  watchdog_coll = coll;
+
+  if(imminent_coll)
+  {
+    return CYCLE_STOP;
+  }
+  return coll ? CYCLE_DECELERATE : CYCLE_TRACK;
+} // End cycleAction
+
+
+
+/** 
+ * This method moves the robot along the latest plan for one control cycle
+ * It is called by the control thread and never blocks, a new trajectory 
+ * takes effect on the first cycle after updateTrajectory publishes it
+ */
+void MobileRobot::moveOnTrajectory() 
+{
+  ros::Time now = ros::Time::now();
+  ros::Duration t_cycle = now - t_prev_cycle_;
+  t_prev_cycle_ = now;
+
+  // Odometry extrapolated to this cycle
+  states_.update();
+  states_.read().predict(now, ms_control_);
+  obstacles_.update();
+
+  // Switch to a new plan, a spliced plan keeps the progress on the previous one
+  if(plans_.update())
+  {
+    if(!plans_.read().spliced)
     {
-      continue;
+      num_traveled_   = 0;
+      num_traveled_active_plan_ = 0;
+      t_immiColl_     = ros::Duration(0);
     }
+    num_            = plans_.read().trajectory.trajectory.points.size();
+    active_plan_    = plans_.read().id;
 
-    // Move to the next point
-    ros::Time g_time = end_times.at(num_traveled_) + t_immiColl_;
-    //ros::Time g_time = end_times.at(num_traveled_);
-    //ROS_INFO("now: %f g_time: %f", ros::Time::now().toSec(), g_time.toSec());
-    while(ros::ok() && ros::Time::now() < g_time) 
+    if(num_ == 0)
+    {
+      ROS_INFO("Stopping at state: %s", utility_.toString(ms_control_).c_str());
+      twist_.linear.x = 0;
+      twist_.angular.z = 0;
+      shaper_.reset(twist_);
+      sendTwist();
+      sendTwist();
+      sendTwist();
+    }
+  }
+
+  const ControlPlan& plan = plans_.read();
+
+  // Execute the trajectory
+  if((num_traveled_+1) < num_) 
+  {
+    // Move past the points whose time was reached
+    double t = (now - plan.t_start - t_immiColl_).toSec();
+    t_active_plan_ = t;
+    while((num_traveled_+1) < num_ && t >= plan.times.at(num_traveled_+1))
     {
-      // If a new trajectory was received, restart the outer while 
-      if(restart_)
+      num_traveled_++;
+    }
+    num_traveled_active_plan_ = num_traveled_;
+
+    if((num_traveled_+1) < num_)
+    {
+      // Slow down without waiting for the planner if the plan is about to hit an obstacle,
+      // and let the planner know when that changes
+      bool notify;
+      CycleAction action = cycleAction(check_imminent_coll_ && imminent_coll_, 
+          watchdog_ && checkWatchdog(plan, num_traveled_, t, now), watchdog_coll_, notify);
+      if(notify)
       {
-        continue;
+        std_msgs::Bool msg;
+        msg.data = watchdog_coll_;
+        pub_watchdog_.publish(msg);
       }
-      
-      twist_.linear.x   = speeds_linear_.at(num_traveled_);
-      twist_.angular.z  = speeds_angular_.at(num_traveled_);
- 
-      // When driving straight, adjust the angular speed 
-      // to maintain orientation
-      // TODO: Works with Bezier curve?
-      if(fabs(twist_.linear.x) > 0.0f && fabs(twist_.angular.z) < 0.0001f) 
+
+      // Force a stop until there is no imminent collision, the time stopped 
+      // delays the rest of the trajectory
+      if(action == CYCLE_STOP)
       {
-        //ROS_INFO("initial_theta_: %f motion_state_.positions.at(2): %f", initial_theta_, motion_state_.positions.at(2));
-        actual_theta = utility_.displaceAngle(initial_theta_, motion_state_.positions.at(2));
-        dist = utility_.findDistanceBetweenAngles(actual_theta, orientations_.at(num_traveled_));
-        //ROS_INFO("actual_theta: %f orientations[%i]: %f dist: %f", actual_theta, num_traveled_, orientations_.at(num_traveled_), dist);
-        twist_.angular.z = dist/2.f;
+        ROS_ERROR("Imminent Collision Exists, Stopping robot");
+        sendTwist(zero_twist_);
+        shaper_.reset(zero_twist_);
+        t_immiColl_ += t_cycle;
+        return;
       }
 
+      if(action == CYCLE_DECELERATE)
+      {
+        ROS_ERROR("Watchdog found a collision on the trajectory, slowing down");
+        decelerate(t_cycle.toSec());
+        shaper_.reset(twist_);
+        sendTwist();
+        t_immiColl_ += t_cycle;
+        return;
+      }
+
+      //ROS_INFO("num_traveled_: %i/%i t: %f", num_traveled_, num_, t);
+      ControlReference ref;
+      getReference(plan, num_traveled_, t, ref);
+      // Smooth the tracking controller's twist to the robot's limits
+      geometry_msgs::Twist desired;
+      computeTwist(ref, desired);
+      shaper_.shape(desired, ref.a_v, ref.a_w, t_cycle.toSec() > 0 ? t_cycle.toSec() : 1./control_rate_, twist_);
+
       //ROS_INFO("twist.linear.x: %f twist.angular.z: %f", twist_.linear.x, twist_.angular.z);
 
       // Send the twist_message to move the robot
       sendTwist();
-      
-      // Sleep
-      r.sleep();
-    
-      // Spin to check for updates
-      ros::spinOnce();
-    } // end while (move to the next point)
-    
-    // If a new trajectory was received, restart the outer while 
-    if(restart_) 
-    {
-      continue;
+      return;
     }
+  }
 
-    // Increment num_traveled
-    num_traveled_++;
-
-    // Spin once to check for updates in the trajectory
-    ros::spinOnce();
-
-    //t_points_.push_back(ros::Time::now() - s);
-    //ROS_INFO("Point took %f", (ros::Time::now() - s).toSec());
-  } // end while
-
-  // Check that we moved on a trajectory
-  if(num_traveled_ > 1)
+  // Check that we finished moving on a trajectory
+  if(num_ > 0)
   {
     // Stops the wheels
     twist_.linear.x = 0;
     twist_.angular.z = 0;
+    shaper_.reset(twist_);
     sendTwist();
     sendTwist();
 
     // Set num and num_traveled so we don't come back into this if-block each time
     num_ = 0;
     num_traveled_ = 0;
+    num_traveled_active_plan_ = 0;
+    active_plan_ = 0;
+
+    if(watchdog_coll_)
+    {
+      watchdog_coll_ = false;
+      std_msgs::Bool msg;
+      msg.data = false;
+      pub_watchdog_.publish(msg);
+    }
   } // end if finished a trajectory
 } // End moveOnTrajectory
 
-
@@ -0,0 +1,89 @@
+#include "state_estimator.h"
+
+StateEstimator::StateEstimator() : initialized_(false)
+{
+  for(unsigned int i=0;i<3;i++)
+  {
+    ms_.positions.push_back(0);
+    ms_.velocities.push_back(0);
+    ms_.accelerations.push_back(0);
+    ms_.jerks.push_back(0);
+  }
+}
+
+StateEstimator::~StateEstimator() {}
+
+
+
+void StateEstimator::update(const nav_msgs::Odometry& msg, const ros::Time& t)
+{
+  ros::Time t_msg = msg.header.stamp.isZero() ? t : msg.header.stamp;
+
+  double v[3] = { msg.twist.twist.linear.x, msg.twist.twist.linear.y, msg.twist.twist.angular.z };
+
+  // Filter the accelerations, odometry velocities are noisy
+  double dt = (t_msg - t_).toSec();
+  for(unsigned int i=0;i<3;i++)
+  {
+    if(initialized_ && dt > 0.001)
+    {
+      double a = (v[i] - ms_.velocities.at(i)) / dt;
+      ms_.accelerations.at(i) = ACCELERATION_FILTER*a + (1.-ACCELERATION_FILTER)*ms_.accelerations.at(i);
+    }
+    ms_.velocities.at(i) = v[i];
+  }
+
+  ms_.positions.at(0) = msg.pose.pose.position.x;
+  ms_.positions.at(1) = msg.pose.pose.position.y;
+  ms_.positions.at(2) = tf::getYaw(msg.pose.pose.orientation);
+
+  t_            = t_msg;
+  initialized_  = true;
+} // End update
+
+
+
+/**
+ * Integrate the unicycle model from the latest odometry to t, using the 
+ * heading halfway through the interval
+ */
+void StateEstimator::predict(const ros::Time& t, ramp_msgs::MotionState& result) const
+{
+  result.positions      = ms_.positions;
+  result.velocities     = ms_.velocities;
+  result.accelerations  = ms_.accelerations;
+  result.jerks          = ms_.jerks;
+
+  double dt = initialized_ ? (t - t_).toSec() : 0;
+  if(dt <= 0)
+  {
+    return;
+  }
+  dt = dt > MAX_EXTRAPOLATION ? MAX_EXTRAPOLATION : dt;
+
+  for(unsigned int i=0;i<3;i++)
+  {
+    result.velocities.at(i) = ms_.velocities.at(i) + ms_.accelerations.at(i)*dt;
+  }
+
+  double d_theta  = ms_.velocities.at(2)*dt + 0.5*ms_.accelerations.at(2)*dt*dt;
+  double d_x      = ms_.velocities.at(0)*dt + 0.5*ms_.accelerations.at(0)*dt*dt;
+  double d_y      = ms_.velocities.at(1)*dt + 0.5*ms_.accelerations.at(1)*dt*dt;
+  double theta    = ms_.positions.at(2) + 0.5*d_theta;
+
+  result.positions.at(0) += d_x*cos(theta) - d_y*sin(theta);
+  result.positions.at(1) += d_x*sin(theta) + d_y*cos(theta);
+  result.positions.at(2) = atan2(sin(ms_.positions.at(2) + d_theta), cos(ms_.positions.at(2) + d_theta));
+} // End predict
+
+
+
+const ramp_msgs::MotionState& StateEstimator::latest() const
+{
+  return ms_;
+}
+
+const ros::Time& StateEstimator::latestTime() const
+{
+  return t_;
+}
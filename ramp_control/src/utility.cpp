@@ -1,4 +1,6 @@
 #include "utility.h"
+#include <pthread.h>
+#include <string.h>
 
 Utility::Utility() {}
 
@@ -234,3 +236,17 @@ const std::string Utility::toString(const ramp_msgs::RampTrajectory traj) const
   return result.str();
 }
 
+
+
+const bool Utility::setRealTimePriority(boost::thread& thread, const int priority) const {
+  struct sched_param param;
+  param.sched_priority = priority;
+  int err = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+  if(err != 0)
+  {
+    ROS_WARN("Could not set SCHED_FIFO priority %i: %s", priority, strerror(err));
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include "../include/mobile_robot.h"
+
+
+/** The planner raises the imminent collision while the watchdog reports a collision */
+struct WatchdogLoop
+{
+  WatchdogLoop() : ic(false), watchdog_coll(false), num_notify(0) {}
+
+  CycleAction cycle(const bool coll)
+  {
+    bool notify;
+    CycleAction result = MobileRobot::cycleAction(ic, coll, watchdog_coll, notify);
+    if(notify)
+    {
+      num_notify++;
+      ic = watchdog_coll;
+    }
+    return result;
+  }
+
+  bool ic;
+  bool watchdog_coll;
+  int  num_notify;
+};
+
+
+TEST(TestSuite, watchdogRaisesAndClearsIC)
+{
+  WatchdogLoop loop;
+
+  EXPECT_EQ(CYCLE_TRACK, loop.cycle(false));
+  EXPECT_EQ(0, loop.num_notify);
+
+  // The watchdog slows the robot down and the planner stops it
+  EXPECT_EQ(CYCLE_DECELERATE, loop.cycle(true));
+  EXPECT_EQ(1, loop.num_notify);
+  EXPECT_TRUE(loop.ic);
+
+  EXPECT_EQ(CYCLE_STOP, loop.cycle(true));
+  EXPECT_EQ(CYCLE_STOP, loop.cycle(true));
+  EXPECT_EQ(1, loop.num_notify);
+
+  // The obstacle leaves while the robot is held, the planner has to hear it
+  EXPECT_EQ(CYCLE_STOP, loop.cycle(false));
+  EXPECT_EQ(2, loop.num_notify);
+  EXPECT_FALSE(loop.ic);
+
+  EXPECT_EQ(CYCLE_TRACK, loop.cycle(false));
+  EXPECT_EQ(2, loop.num_notify);
+}
+
+
+TEST(TestSuite, imminentCollisionWithoutWatchdog)
+{
+  bool watchdog_coll = false;
+  bool notify;
+
+  // An imminent collision from the planner alone stops the robot and reports nothing
+  EXPECT_EQ(CYCLE_STOP, MobileRobot::cycleAction(true, false, watchdog_coll, notify));
+  EXPECT_FALSE(notify);
+  EXPECT_FALSE(watchdog_coll);
+
+  EXPECT_EQ(CYCLE_TRACK, MobileRobot::cycleAction(false, false, watchdog_coll, notify));
+  EXPECT_FALSE(notify);
+}
+
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,250 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+#include <string>
+#include <new>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <boost/atomic.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <ros/serialization.h>
+
+
+/**
+ * Lock-free single producer, single consumer ring of fixed size slots in a
+ * POSIX shared memory segment. One process creates the segment, the other
+ * opens it, and each message is serialized straight into its slot with the
+ * ROS serializer so neither side copies it through a socket
+ *
+ * Each slot carries a sequence number chosen by the producer, which lets a
+ * request and its result be matched up across two rings. Only one thread
+ * may push and only one thread may pop at a time, a process that pushes
+ * into a segment it did not create attaches with openProducer so a second
+ * one is refused
+ *
+ * Header-only so the planner and the evaluator can share it through ramp_msgs
+ */
+class ShmRing
+{
+  public:
+
+    ShmRing() : header_(0), slots_(0), producer_(false) {}
+    ~ShmRing() { close(); }
+
+    /** Create the segment, replacing one left behind by a previous run */
+    const bool create(const std::string& name, const uint32_t num_slots, const uint32_t slot_size)
+    {
+      using namespace boost::interprocess;
+      close();
+      remove(name);
+
+      uint32_t stride = slotStride(slot_size);
+      try
+      {
+        shared_memory_object shm(create_only, name.c_str(), read_write);
+        shm.truncate(HEADER_SIZE + (offset_t)num_slots*stride);
+        mapped_region region(shm, read_write);
+        region_.swap(region);
+      }
+      catch(const interprocess_exception& e)
+      {
+        return false;
+      }
+
+      // truncate zeroes the segment, the atomics still need constructing
+      header_ = static_cast<Header*>(region_.get_address());
+      new (&header_->head) boost::atomic<uint32_t>(0);
+      new (&header_->tail) boost::atomic<uint32_t>(0);
+      new (&header_->ready) boost::atomic<uint32_t>(0);
+      new (&header_->producer) boost::atomic<uint32_t>(0);
+      header_->num_slots = num_slots;
+      header_->slot_size = slot_size;
+      header_->stride    = stride;
+      slots_ = static_cast<uint8_t*>(region_.get_address()) + HEADER_SIZE;
+
+      // Publish last so open never sees a half initialized header
+      header_->ready.store(MAGIC, boost::memory_order_release);
+      return true;
+    }
+
+    /** Attach to a segment made by create, false if there is none yet */
+    const bool open(const std::string& name)
+    {
+      using namespace boost::interprocess;
+      close();
+
+      try
+      {
+        shared_memory_object shm(open_only, name.c_str(), read_write);
+        mapped_region region(shm, read_write);
+        region_.swap(region);
+      }
+      catch(const interprocess_exception& e)
+      {
+        return false;
+      }
+
+      header_ = static_cast<Header*>(region_.get_address());
+      if(region_.get_size() < HEADER_SIZE || header_->ready.load(boost::memory_order_acquire) != MAGIC ||
+          region_.get_size() < HEADER_SIZE + (std::size_t)header_->num_slots*header_->stride)
+      {
+        close();
+        return false;
+      }
+
+      slots_ = static_cast<uint8_t*>(region_.get_address()) + HEADER_SIZE;
+      return true;
+    }
+
+    /** 
+     * Attach like open and claim the producer side, false if a process that
+     * is still running already claimed it
+     */
+    const bool openProducer(const std::string& name)
+    {
+      if(!open(name))
+      {
+        return false;
+      }
+
+      // A producer that exited without closing leaves its pid behind
+      uint32_t pid   = getpid();
+      uint32_t owner = header_->producer.load(boost::memory_order_acquire);
+      if((owner != 0 && processAlive(owner)) || !header_->producer.compare_exchange_strong(owner, pid))
+      {
+        close();
+        return false;
+      }
+
+      producer_ = true;
+      return true;
+    } // End openProducer
+
+    void close()
+    {
+      if(producer_ && header_)
+      {
+        uint32_t pid = getpid();
+        header_->producer.compare_exchange_strong(pid, 0);
+      }
+      producer_ = false;
+
+      boost::interprocess::mapped_region empty;
+      region_.swap(empty);
+      header_ = 0;
+      slots_  = 0;
+    }
+
+    static void remove(const std::string& name)
+    {
+      boost::interprocess::shared_memory_object::remove(name.c_str());
+    }
+
+    const bool isOpen() const
+    {
+      return header_ != 0;
+    }
+
+    /** Largest serialized message a slot holds */
+    const uint32_t slotSize() const
+    {
+      return header_ ? header_->slot_size : 0;
+    }
+
+    const bool empty() const
+    {
+      return header_->head.load(boost::memory_order_acquire) == header_->tail.load(boost::memory_order_relaxed);
+    }
+
+    /** Serialize msg into the next slot, false if the ring is full or msg does not fit */
+    template <class M>
+    const bool push(const uint32_t seq, const M& msg)
+    {
+      uint32_t head = header_->head.load(boost::memory_order_relaxed);
+      if(head - header_->tail.load(boost::memory_order_acquire) >= header_->num_slots)
+      {
+        return false;
+      }
+
+      uint32_t size = ros::serialization::serializationLength(msg);
+      if(size > header_->slot_size)
+      {
+        return false;
+      }
+
+      uint8_t* slot = slotAt(head);
+      reinterpret_cast<uint32_t*>(slot)[0] = seq;
+      reinterpret_cast<uint32_t*>(slot)[1] = size;
+      ros::serialization::OStream stream(slot + SLOT_HEADER_SIZE, size);
+      ros::serialization::serialize(stream, msg);
+
+      header_->head.store(head+1, boost::memory_order_release);
+      return true;
+    } // End push
+
+    /** Deserialize the oldest slot into msg and free it, false if the ring is empty */
+    template <class M>
+    const bool pop(uint32_t& seq, M& msg)
+    {
+      uint32_t tail = header_->tail.load(boost::memory_order_relaxed);
+      if(header_->head.load(boost::memory_order_acquire) == tail)
+      {
+        return false;
+      }
+
+      uint8_t* slot = slotAt(tail);
+      seq           = reinterpret_cast<uint32_t*>(slot)[0];
+      uint32_t size = reinterpret_cast<uint32_t*>(slot)[1];
+      ros::serialization::IStream stream(slot + SLOT_HEADER_SIZE, size);
+      ros::serialization::deserialize(stream, msg);
+
+      header_->tail.store(tail+1, boost::memory_order_release);
+      return true;
+    } // End pop
+
+  private:
+
+    static const uint32_t MAGIC            = 0x52414d50;
+    static const uint32_t CACHE_LINE       = 64;
+    static const uint32_t SLOT_HEADER_SIZE = 8;
+
+    // head and tail on their own cache lines so the two processes don't share one
+    struct Header
+    {
+      boost::atomic<uint32_t> head;
+      uint8_t pad_head[CACHE_LINE - sizeof(boost::atomic<uint32_t>)];
+      boost::atomic<uint32_t> tail;
+      uint8_t pad_tail[CACHE_LINE - sizeof(boost::atomic<uint32_t>)];
+      boost::atomic<uint32_t> ready;
+      boost::atomic<uint32_t> producer;
+      uint32_t num_slots;
+      uint32_t slot_size;
+      uint32_t stride;
+    };
+
+    static const std::size_t HEADER_SIZE = ((sizeof(Header) + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE;
+
+    static const uint32_t slotStride(const uint32_t slot_size)
+    {
+      return ((SLOT_HEADER_SIZE + slot_size + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE;
+    }
+
+    static const bool processAlive(const uint32_t pid)
+    {
+      return kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    uint8_t* slotAt(const uint32_t i) const
+    {
+      return slots_ + (std::size_t)(i % header_->num_slots) * header_->stride;
+    }
+
+    boost::interprocess::mapped_region region_;
+    Header* header_;
+    uint8_t* slots_;
+    bool producer_;
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+#include <vector>
+#include <math.h>
+
+
+/**
+ * Uniform grid over 2D points, each point has an id chosen by the caller 
+ * (e.g. the index of an obstacle). The grid covers the bounding box of the
+ * points it was built with and is rebuilt whenever the points change, which 
+ * for obstacles is once per sensing cycle. Points are stored sorted by cell 
+ * so a query only reads the cells that overlap it
+ *
+ * Header-only so the planner and the evaluator can share it through ramp_msgs
+ */
+class SpatialGrid 
+{
+  public:
+
+    explicit SpatialGrid(const double cell_size=1.) : cell_size_(cell_size), x_min_(0), y_min_(0), n_x_(0), n_y_(0) {}
+    ~SpatialGrid() {}
+
+    void clear()
+    {
+      pending_.clear();
+      entries_.clear();
+      cell_start_.clear();
+      n_x_ = 0;
+      n_y_ = 0;
+    }
+
+    void setCellSize(const double cell_size)
+    {
+      cell_size_ = cell_size;
+    }
+
+    // Add a point, it can be queried after the next call to build
+    void insert(const int id, const double x, const double y)
+    {
+      Entry e;
+      e.id  = id;
+      e.x   = x;
+      e.y   = y;
+      pending_.push_back(e);
+    }
+
+    // Sort the inserted points into cells
+    void build()
+    {
+      entries_.clear();
+      cell_start_.clear();
+      n_x_ = 0;
+      n_y_ = 0;
+      if(pending_.size() == 0)
+      {
+        return;
+      }
+
+      double x_max = pending_[0].x, y_max = pending_[0].y;
+      x_min_ = pending_[0].x;
+      y_min_ = pending_[0].y;
+      for(unsigned int i=1;i<pending_.size();i++)
+      {
+        x_min_ = pending_[i].x < x_min_ ? pending_[i].x : x_min_;
+        y_min_ = pending_[i].y < y_min_ ? pending_[i].y : y_min_;
+        x_max  = pending_[i].x > x_max  ? pending_[i].x : x_max;
+        y_max  = pending_[i].y > y_max  ? pending_[i].y : y_max;
+      }
+      n_x_ = (int)((x_max - x_min_) / cell_size_) + 1;
+      n_y_ = (int)((y_max - y_min_) / cell_size_) + 1;
+
+      // Counting sort by cell
+      cell_start_.assign(n_x_*n_y_ + 1, 0);
+      for(unsigned int i=0;i<pending_.size();i++)
+      {
+        cell_start_[ getCell(pending_[i].x, pending_[i].y) + 1 ]++;
+      }
+      for(unsigned int c=1;c<cell_start_.size();c++)
+      {
+        cell_start_[c] += cell_start_[c-1];
+      }
+
+      std::vector<int> next(cell_start_.begin(), cell_start_.end()-1);
+      entries_.resize(pending_.size());
+      for(unsigned int i=0;i<pending_.size();i++)
+      {
+        entries_[ next[getCell(pending_[i].x, pending_[i].y)]++ ] = pending_[i];
+      }
+
+      pending_.clear();
+    } // End build
+
+    const unsigned int size() const
+    {
+      return entries_.size();
+    }
+
+    /** Id of the closest point to (x,y) and its distance, returns -1 if there are no points */
+    const int nearest(const double x, const double y, double& dist) const
+    {
+      int result = -1;
+      dist = -1;
+      if(entries_.size() == 0)
+      {
+        return result;
+      }
+
+      int cx = clampX( (int)floor((x - x_min_) / cell_size_) );
+      int cy = clampY( (int)floor((y - y_min_) / cell_size_) );
+
+      // Search rings of cells around (x,y) until no closer point can be in the next ring
+      int n_rings = n_x_ > n_y_ ? n_x_ : n_y_;
+      for(int ring=0;ring<=n_rings;ring++)
+      {
+        for(int j=cy-ring;j<=cy+ring;j++)
+        {
+          for(int i=cx-ring;i<=cx+ring;i++)
+          {
+            // Only the border of the ring
+            if(i < 0 || j < 0 || i >= n_x_ || j >= n_y_ || 
+                (abs(i-cx) != ring && abs(j-cy) != ring))
+            {
+              continue;
+            }
+
+            for(int k=cell_start_[j*n_x_ + i];k<cell_start_[j*n_x_ + i + 1];k++)
+            {
+              double d = sqrt( pow(entries_[k].x - x, 2) + pow(entries_[k].y - y, 2) );
+              if(result == -1 || d < dist)
+              {
+                result  = entries_[k].id;
+                dist    = d;
+              }
+            }
+          } // end for i
+        } // end for j
+
+        // Distance from (x,y) to the outside of the rings searched so far
+        double to_border = distToCellBorder(x, y, cx, cy, ring);
+        if(result != -1 && dist <= to_border)
+        {
+          break;
+        }
+      } // end for ring
+
+      return result;
+    } // End nearest
+
+    /** Ids of the points within r of (x,y), ids are repeated if several points have the same id */
+    void radius(const double x, const double y, const double r, std::vector<int>& result) const
+    {
+      result.clear();
+      corridor(x, y, x, y, r, result);
+    } // End radius
+
+    /** Ids of the points within r of the segment from (x0,y0) to (x1,y1) */
+    void corridor(const double x0, const double y0, const double x1, const double y1, const double r, std::vector<int>& result) const
+    {
+      result.clear();
+      if(entries_.size() == 0)
+      {
+        return;
+      }
+
+      int i_min = clampX( (int)floor(((x0 < x1 ? x0 : x1) - r - x_min_) / cell_size_) );
+      int i_max = clampX( (int)floor(((x0 > x1 ? x0 : x1) + r - x_min_) / cell_size_) );
+      int j_min = clampY( (int)floor(((y0 < y1 ? y0 : y1) - r - y_min_) / cell_size_) );
+      int j_max = clampY( (int)floor(((y0 > y1 ? y0 : y1) + r - y_min_) / cell_size_) );
+
+      double dx = x1 - x0;
+      double dy = y1 - y0;
+      double l2 = dx*dx + dy*dy;
+
+      for(int j=j_min;j<=j_max;j++)
+      {
+        for(int i=i_min;i<=i_max;i++)
+        {
+          for(int k=cell_start_[j*n_x_ + i];k<cell_start_[j*n_x_ + i + 1];k++)
+          {
+            // Closest point on the segment
+            double t = l2 > 0 ? ((entries_[k].x - x0)*dx + (entries_[k].y - y0)*dy) / l2 : 0;
+            t = t < 0 ? 0 : t > 1 ? 1 : t;
+            double d = sqrt( pow(x0 + t*dx - entries_[k].x, 2) + pow(y0 + t*dy - entries_[k].y, 2) );
+            if(d <= r)
+            {
+              result.push_back(entries_[k].id);
+            }
+          }
+        }
+      }
+    } // End corridor
+
+  private:
+
+    struct Entry 
+    {
+      int id;
+      double x, y;
+    };
+
+    double cell_size_;
+    double x_min_, y_min_;
+    int n_x_, n_y_;
+
+    std::vector<Entry> pending_;
+    std::vector<Entry> entries_;
+
+    // Entries of cell c are [cell_start_[c], cell_start_[c+1])
+    std::vector<int> cell_start_;
+
+    const int getCell(const double x, const double y) const
+    {
+      return clampY( (int)((y - y_min_) / cell_size_) ) * n_x_ + clampX( (int)((x - x_min_) / cell_size_) );
+    }
+
+    const int clampX(const int i) const
+    {
+      return i < 0 ? 0 : i >= n_x_ ? n_x_-1 : i;
+    }
+
+    const int clampY(const int j) const
+    {
+      return j < 0 ? 0 : j >= n_y_ ? n_y_-1 : j;
+    }
+
+    // Distance from (x,y) to the outer edge of the cells within ring of (cx,cy)
+    const double distToCellBorder(const double x, const double y, const int cx, const int cy, const int ring) const
+    {
+      double left   = x - (x_min_ + (cx - ring)*cell_size_);
+      double right  = (x_min_ + (cx + ring + 1)*cell_size_) - x;
+      double bottom = y - (y_min_ + (cy - ring)*cell_size_);
+      double top    = (y_min_ + (cy + ring + 1)*cell_size_) - y;
+
+      double result = left;
+      result = right  < result ? right  : result;
+      result = bottom < result ? bottom : result;
+      result = top    < result ? top    : result;
+      return result;
+    }
+};
+
+#endif
@@ -2,6 +2,19 @@
 #define EVALUATION_REQUEST_HANDLER_H
 #include "ros/ros.h"
 #include "ramp_msgs/EvaluationSrv.h"
+#include "shm_ring.h"
+#include "persistent_service_client.h"
+#include <future>
+#include <boost/thread/mutex.hpp>
+
+// How long to wait for the evaluator on the shared memory rings before falling back to the service
+#define SHM_TIMEOUT 0.5
+
+// Polls of the result ring before the wait starts sleeping between them
+#define SHM_SPIN_POLLS 2000
+
+// Seconds between attempts to attach to the evaluator's rings
+#define SHM_REOPEN_PERIOD 1.0
 
 class EvaluationRequestHandler {
   public:
@@ -9,10 +22,28 @@ class EvaluationRequestHandler {
 
     //Cannot make mr const because it has no serialize/deserialize 
     const bool request(ramp_msgs::EvaluationSrv& er);
+
+    /** Make the request on another thread, er must not be used until the future is ready */
+    std::future<bool> requestAsync(ramp_msgs::EvaluationSrv& er);
+
+    const LatencyHistogram& latencies() const;
   
   private:
+    const bool requestShm(ramp_msgs::EvaluationSrv& er);
+    const bool openShm();
+
     ros::NodeHandle handle_;
-    ros::ServiceClient client_;
+    LatencyHistogram latencies_;
+    PersistentServiceClient<ramp_msgs::EvaluationSrv> client_;
+
+    // Optional transport when the evaluator runs on the same host, see ramp/eval_shared_memory
+    bool                use_shm_;
+    std::string         shm_name_;
+    ShmRing             ring_requests_;
+    ShmRing             ring_results_;
+    uint32_t            seq_;
+    ros::WallTime       t_next_open_;
+    boost::mutex        mutex_shm_;
 };
 
 #endif
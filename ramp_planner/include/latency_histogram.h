@@ -0,0 +1,41 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+#include "ros/ros.h"
+#include <boost/thread/mutex.hpp>
+
+// Buckets double in width from 1us, the last one holds everything above ~8s
+#define LATENCY_BUCKETS 24
+
+/**
+ * Log scale histogram of call durations, cheap enough to record every call.
+ * Bucket i counts durations in [2^(i-1), 2^i) microseconds
+ */
+class LatencyHistogram {
+  public:
+    LatencyHistogram(const std::string& label);
+
+    void record(const ros::WallDuration& d);
+    void recordFailure();
+
+    const uint32_t count() const;
+    const uint32_t failures() const;
+    const double   mean() const;
+
+    /** Upper edge in seconds of the bucket holding the p'th fraction of calls, at most the slowest call */
+    const double percentile(const double p) const;
+
+    const std::string toString() const;
+
+  private:
+    const double percentileLocked(const double p) const;
+
+    std::string label_;
+    uint32_t    buckets_[LATENCY_BUCKETS];
+    uint32_t    count_;
+    uint32_t    failures_;
+    double      sum_;
+    double      max_;
+    mutable boost::mutex mutex_;
+};
+
+#endif
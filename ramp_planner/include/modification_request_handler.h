@@ -2,17 +2,25 @@
 #define MODIFICATION_REQUEST_HANDLER_H
 #include "ros/ros.h"
 #include "ramp_msgs/ModificationRequest.h"
+#include "persistent_service_client.h"
+#include <future>
 
 class ModificationRequestHandler {
   public:
     ModificationRequestHandler(const ros::NodeHandle& h);
    
     //Cannot make mr const because it has no serialize/deserialize 
-    const bool request(ramp_msgs::ModificationRequest& mr);   
+    const bool request(ramp_msgs::ModificationRequest& mr);
+
+    /** Make the request on another thread, mr must not be used until the future is ready */
+    std::future<bool> requestAsync(ramp_msgs::ModificationRequest& mr);   
+
+    const LatencyHistogram& latencies() const;
 
   private:
     ros::NodeHandle handle_;
-    ros::ServiceClient client_;
+    LatencyHistogram latencies_;
+    PersistentServiceClient<ramp_msgs::ModificationRequest> client_;
    
 };
 
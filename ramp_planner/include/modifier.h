@@ -4,6 +4,7 @@
 #include "population.h"
 #include "ramp_msgs/ModificationRequest.h"
 #include "modification_request_handler.h"
+#include <future>
 
 class Modifier {
   public:
@@ -12,7 +13,14 @@ class Modifier {
 
     // Methods
     const std::vector<Path> perform(const Population& pop, bool imminent_collision=false);
+
+    // perform split in two so the planner can work while the request is out
+    void startPerform(const Population& pop, bool imminent_collision=false);
+    const bool performing() const;
+    const std::vector<Path> finishPerform();
+
     void buildModificationRequest(const Population& pop, bool imminent_collision, ramp_msgs::ModificationRequest& result);
+    const LatencyHistogram& latencies() const;
 
 
     // Data members
@@ -23,8 +31,11 @@ class Modifier {
   private:
     const std::string getOperator() const;
     const std::vector<int> getTargets(const std::string& op, const Population& pop);
+    void getModifiedPaths(const ramp_msgs::ModificationRequest& mr, std::vector<Path>& result) const;
 
     ModificationRequestHandler* h_mod_req_;
+    ramp_msgs::ModificationRequest mr_pending_;
+    std::future<bool> pending_;
     Utility u;
 };
 
@@ -0,0 +1,101 @@
+#ifndef PERSISTENT_SERVICE_CLIENT_H
+#define PERSISTENT_SERVICE_CLIENT_H
+#include "ros/ros.h"
+#include "latency_histogram.h"
+
+// Attempts per call before giving up, each failed attempt reconnects
+#define SERVICE_MAX_ATTEMPTS 3
+
+// Seconds a call may spend on all of its attempts, including waiting for the service
+#define SERVICE_DEADLINE 1.0
+
+// Wait before the second attempt, doubles after each further failure
+#define SERVICE_RETRY_BACKOFF 0.01
+
+
+/**
+ * Service client that keeps one persistent connection to the server so a
+ * call does not look the service up on the master and open a new socket.
+ * A call that fails drops the connection and is retried on a fresh one
+ * until it succeeds, runs out of attempts or passes its deadline
+ *
+ * Every call's duration goes into the caller's LatencyHistogram
+ */
+template <class S>
+class PersistentServiceClient {
+  public:
+    PersistentServiceClient(const ros::NodeHandle& h, const std::string& service, LatencyHistogram& latencies) 
+      : handle_(h), service_(service), latencies_(latencies) {}
+
+    const bool call(S& srv)
+    {
+      ros::WallTime t_start    = ros::WallTime::now();
+      ros::WallTime t_deadline = t_start + ros::WallDuration(SERVICE_DEADLINE);
+      double backoff           = SERVICE_RETRY_BACKOFF;
+
+      for(int attempt=0;attempt<SERVICE_MAX_ATTEMPTS;attempt++)
+      {
+        ros::ServiceClient client = connection(t_deadline);
+        if(client && client.call(srv))
+        {
+          latencies_.record(ros::WallTime::now() - t_start);
+          return true;
+        }
+
+        reset(client);
+        
+        ros::WallDuration remaining = t_deadline - ros::WallTime::now();
+        if(remaining.toSec() <= backoff)
+        {
+          break;
+        }
+        ros::WallDuration(backoff).sleep();
+        backoff *= 2;
+      }
+
+      latencies_.recordFailure();
+      ROS_ERROR_THROTTLE(1, "Service %s failed after %f s", service_.c_str(), (ros::WallTime::now() - t_start).toSec());
+      return false;
+    } // End call
+
+  private:
+
+    /** The persistent client, connecting first if there is none */
+    ros::ServiceClient connection(const ros::WallTime& t_deadline)
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if(client_ && client_.isValid())
+      {
+        return client_;
+      }
+
+      // Waiting for the server here keeps the call from failing while it (re)starts
+      ros::WallDuration remaining = t_deadline - ros::WallTime::now();
+      if(remaining.toSec() <= 0 || !ros::service::waitForService(service_, ros::Duration(remaining.toSec())))
+      {
+        return ros::ServiceClient();
+      }
+
+      client_ = handle_.serviceClient<S>(service_, true);
+      return client_;
+    } // End connection
+
+    /** Drop the connection that just failed, unless another caller already replaced it */
+    void reset(const ros::ServiceClient& failed)
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if(client_ == failed)
+      {
+        client_.shutdown();
+        client_ = ros::ServiceClient();
+      }
+    }
+
+    ros::NodeHandle     handle_;
+    std::string         service_;
+    ros::ServiceClient  client_;
+    LatencyHistogram&   latencies_;
+    boost::mutex        mutex_;
+};
+
+#endif
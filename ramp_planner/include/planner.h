@@ -12,7 +12,24 @@
 #include "control_handler.h"
 #include "parameter_handler.h"
 #include "bezier_curve.h"
+#include "spatial_grid.h"
 #include <type_traits>
+#include <future>
+
+// Number of knot points, including the new start, regenerated by incremental adaptation
+#define ADAPT_HEAD_KNOTS 3
+
+// Tolerance for the state at the end of the head to match the old trajectory
+#define ADAPT_SPLICE_THRESHOLD 0.01
+
+// Cell size of the obstacle index, close to the distances it is queried with
+#define OB_INDEX_CELL_SIZE 0.5
+
+// Longest time latestUpdate_ is extrapolated for
+#define UPDATE_MAX_EXTRAPOLATION 0.5
+
+// Error correction offsets add up to this before the population is evaluated again
+#define EC_EVALUATE_THRESHOLD 0.05
 
 struct ModificationResult 
 {
@@ -131,8 +148,6 @@ class Planner {
     // Modify trajectory or path
     const std::vector<Path> modifyPath();
 
-    void modifyTrajec(std::vector<RampTrajectory>& result);
-
 
 
 
@@ -172,6 +187,11 @@ class Planner {
     void requestTrajectory(ramp_msgs::TrajectoryRequest& tr, RampTrajectory& result);
     void requestTrajectory(const Path p, RampTrajectory& result, const int id=-1);
 
+    // Pipelined trajectory requests
+    std::future<bool> requestTrajectoryAsync(const Path& p, ramp_msgs::TrajectorySrv& tr);
+    void finishTrajectoryRequest(std::future<bool>& pending, ramp_msgs::TrajectorySrv& tr, std::vector<RampTrajectory>& result, const int id=-1);
+    void getTrajectoriesFromSrv(const ramp_msgs::TrajectorySrv& tr, std::vector<RampTrajectory>& result, const int id=-1);
+
 
     // Many trajectories
     void requestEvaluation(std::vector<RampTrajectory>& trajecs);
@@ -179,6 +199,7 @@ class Planner {
     // One trajectory
     void requestEvaluation(ramp_msgs::EvaluationRequest& request) const;
     void requestEvaluation(RampTrajectory& t, bool full=true) const;
+    void setEvaluationFailed(ramp_msgs::RampTrajectory& trj) const;
 
 
 
@@ -195,6 +216,12 @@ class Planner {
     void adaptPaths      (const MotionState& ms, const ros::Duration& d, std::vector<Path>& result);
     void adaptPopulation (const MotionState& ms, const ros::Duration& d);
 
+    // Build the path that is regenerated when adapting incrementally
+    const bool getAdaptHead(const Path& path, Path& result) const;
+
+    // Append the part of old that follows the end of head, re-timed to head
+    const bool spliceTail(const RampTrajectory& head, const RampTrajectory& old, const Path& path, RampTrajectory& result) const;
+
     // Display all of the paths
     const std::string pathsToString() const;
 
@@ -214,6 +241,12 @@ class Planner {
     void sensingCycleCallback     (const ramp_msgs::ObstacleList& msg);
     void updateCallback(const ramp_msgs::MotionState& msg);
 
+    // latestUpdate_ extrapolated to time t with its velocities and accelerations
+    const MotionState getPredictedState(const ros::Time& t) const;
+
+    // ramp_control's watchdog reports when it slows down for an obstacle on its own
+    void watchdogCallback(const std_msgs::Bool& msg);
+
     /** Data */
 
     // Motion state that should be reached by next control cycle
@@ -232,6 +265,13 @@ class Planner {
     bool modifications_;
     bool evaluations_;
     bool seedPopulation_;
+
+    // Only regenerate the start of each trajectory when adapting the population
+    bool adaptIncremental_;
+
+    // Heads regenerated by adaptPopulation and how many of them spliced onto the old trajectory
+    int num_adapt_heads_;
+    int num_adapt_spliced_;
     
   //private:
     /** These are (mostly) utility members that are only used by Planner and should not be used by other classes */
@@ -356,6 +396,10 @@ class Planner {
     ros::Time t_IC_;
 
     ros::Time t_prev_update_;
+
+    // Time latestUpdate_ was received, and the error correction offset applied since the last evaluation
+    ros::Time t_latest_update_;
+    double ec_offset_since_eval_;
     ros::Time t_prevIC_;
     ros::Time t_prevObIC_;
     ros::Timer ob_dists_timer_;
@@ -364,6 +408,14 @@ class Planner {
     std::vector<double> ob_dists_;
     std::vector<double> ob_dists_from_obs_;
 
+    // Index over the current position of each obstacle, id = index in ob_trajectory_
+    // Rebuilt each sensing cycle
+    SpatialGrid ob_index_;
+
+    // Version of the obstacle list that ob_trajectory_ was predicted from
+    uint32_t ob_list_version_;
+    void buildObIndex(const uint8_t num_obs);
+
 
     /***** Data members *****/
 
@@ -447,6 +499,9 @@ class Planner {
 
     bool imminent_collision_;
 
+    // True while ramp_control's watchdog sees a collision, counts as imminent collision
+    bool watchdog_collision_;
+
 
     bool moving_on_coll_;
 
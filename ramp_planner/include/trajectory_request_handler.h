@@ -2,6 +2,8 @@
 #define TRAJECTORY_REQUEST_HANDLER_H
 #include "ros/ros.h"
 #include "ramp_msgs/TrajectorySrv.h"
+#include "persistent_service_client.h"
+#include <future>
 
 class TrajectoryRequestHandler {
   public:
@@ -10,9 +12,15 @@ class TrajectoryRequestHandler {
     //Cannot make r const because it has no serialize/deserialize
     const bool request(ramp_msgs::TrajectorySrv& tr);
 
+    /** Make the request on another thread, tr must not be used until the future is ready */
+    std::future<bool> requestAsync(ramp_msgs::TrajectorySrv& tr);
+
+    const LatencyHistogram& latencies() const;
+
   private:
     ros::NodeHandle  handle_; 
-    ros::ServiceClient client_;
+    LatencyHistogram latencies_;
+    PersistentServiceClient<ramp_msgs::TrajectorySrv> client_;
 };
 
 #endif
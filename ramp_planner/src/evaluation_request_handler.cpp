@@ -1,13 +1,123 @@
 #include "evaluation_request_handler.h"
+#include <sched.h>
 
 
-EvaluationRequestHandler::EvaluationRequestHandler(const ros::NodeHandle& h) : handle_(h) 
+EvaluationRequestHandler::EvaluationRequestHandler(const ros::NodeHandle& h) : handle_(h), latencies_("trajectory_evaluation"), 
+  client_(handle_, "/trajectory_evaluation", latencies_), seq_(0)
 {
-  client_ = handle_.serviceClient<ramp_msgs::EvaluationSrv>("/trajectory_evaluation");
+  handle_.param("ramp/eval_shared_memory", use_shm_, false);
+  handle_.param("ramp/eval_shm_name", shm_name_, std::string("ramp_eval"));
 }
 
 
 const bool EvaluationRequestHandler::request(ramp_msgs::EvaluationSrv& er) 
 {
+  if(use_shm_ && requestShm(er))
+  {
+    return true;
+  }
+
   return client_.call(er);
 }
+
+
+std::future<bool> EvaluationRequestHandler::requestAsync(ramp_msgs::EvaluationSrv& er)
+{
+  return std::async(std::launch::async, &EvaluationRequestHandler::request, this, std::ref(er));
+}
+
+
+const LatencyHistogram& EvaluationRequestHandler::latencies() const
+{
+  return latencies_;
+}
+
+
+/** 
+ * Attach to the rings the evaluator created, at most once per SHM_REOPEN_PERIOD.
+ * Only one planner gets the rings of an evaluator, the others use the service
+ */
+const bool EvaluationRequestHandler::openShm()
+{
+  ros::WallTime now = ros::WallTime::now();
+  if(now < t_next_open_)
+  {
+    return false;
+  }
+  t_next_open_ = now + ros::WallDuration(SHM_REOPEN_PERIOD);
+
+  if(!ring_requests_.openProducer(shm_name_ + "_requests") || !ring_results_.open(shm_name_ + "_results"))
+  {
+    ring_requests_.close();
+    ring_results_.close();
+    return false;
+  }
+
+  // Drop results of requests that timed out before a reconnect
+  uint32_t seq;
+  ramp_msgs::EvaluationSrv::Response stale;
+  while(ring_results_.pop(seq, stale)) {}
+
+  ROS_INFO("Evaluating over shared memory (%s)", shm_name_.c_str());
+  return true;
+} // End openShm
+
+
+/**
+ * Send the request through the evaluator's request ring and wait for the 
+ * result with the same sequence number. Returns false when the rings are 
+ * not available, the request does not fit in a slot or the evaluator does 
+ * not answer in time, the caller then uses the service
+ */
+const bool EvaluationRequestHandler::requestShm(ramp_msgs::EvaluationSrv& er)
+{
+  // The rings take one producer and one consumer, serialize the planner's callers
+  boost::mutex::scoped_lock lock(mutex_shm_);
+  ros::WallTime t_start = ros::WallTime::now();
+
+  if(!ring_requests_.isOpen() && !openShm())
+  {
+    return false;
+  }
+
+  uint32_t seq = ++seq_;
+  if(!ring_requests_.push(seq, er.request))
+  {
+    return false;
+  }
+
+  ros::WallTime t_deadline = t_start + ros::WallDuration(SHM_TIMEOUT);
+  uint32_t seq_result;
+  for(int polls=0;;polls++)
+  {
+    while(ring_results_.pop(seq_result, er.response))
+    {
+      if(seq_result == seq)
+      {
+        latencies_.record(ros::WallTime::now() - t_start);
+        return true;
+      }
+    }
+
+    if(ros::WallTime::now() > t_deadline)
+    {
+      break;
+    }
+    
+    if(polls < SHM_SPIN_POLLS)
+    {
+      sched_yield();
+    }
+    else
+    {
+      ros::WallDuration(0.00005).sleep();
+    }
+  }
+
+  // The evaluator may have restarted with new rings, attach again on a later request
+  ROS_WARN("No result from the evaluator over shared memory, using the service");
+  ring_requests_.close();
+  ring_results_.close();
+  er.response.resps.clear();
+  return false;
+} // End requestShm
@@ -0,0 +1,105 @@
+#include "latency_histogram.h"
+
+
+LatencyHistogram::LatencyHistogram(const std::string& label) : label_(label), count_(0), failures_(0), sum_(0), max_(0) 
+{
+  for(int i=0;i<LATENCY_BUCKETS;i++)
+  {
+    buckets_[i] = 0;
+  }
+}
+
+
+void LatencyHistogram::record(const ros::WallDuration& d)
+{
+  double s = d.toSec();
+
+  int i=0;
+  for(double edge = 1e-6; s >= edge && i < LATENCY_BUCKETS-1; edge *= 2)
+  {
+    i++;
+  }
+
+  boost::mutex::scoped_lock lock(mutex_);
+  buckets_[i]++;
+  count_++;
+  sum_ += s;
+  if(s > max_)
+  {
+    max_ = s;
+  }
+}
+
+
+void LatencyHistogram::recordFailure()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  failures_++;
+}
+
+
+const uint32_t LatencyHistogram::count() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return count_;
+}
+
+
+const uint32_t LatencyHistogram::failures() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return failures_;
+}
+
+
+const double LatencyHistogram::mean() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return count_ > 0 ? sum_ / count_ : 0;
+}
+
+
+const double LatencyHistogram::percentile(const double p) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return percentileLocked(p);
+}
+
+
+const double LatencyHistogram::percentileLocked(const double p) const
+{
+  if(count_ == 0)
+  {
+    return 0;
+  }
+
+  uint32_t target = ceil(p * count_);
+  uint32_t seen   = 0;
+  double edge     = 1e-6;
+  for(int i=0;i<LATENCY_BUCKETS-1;i++,edge*=2)
+  {
+    seen += buckets_[i];
+    if(seen >= target)
+    {
+      return edge < max_ ? edge : max_;
+    }
+  }
+
+  return max_;
+} // End percentileLocked
+
+
+const std::string LatencyHistogram::toString() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  std::ostringstream result;
+
+  result<<label_<<": "<<count_<<" calls, "<<failures_<<" failed";
+  if(count_ > 0)
+  {
+    result<<", mean: "<<sum_ / count_<<" p50: <"<<percentileLocked(0.5)<<" p90: <"<<percentileLocked(0.9)
+      <<" p99: <"<<percentileLocked(0.99)<<" max: "<<max_;
+  }
+
+  return result.str();
+} // End toString
@@ -15,6 +15,7 @@ bool                sub_populations;
 bool                modifications;
 bool                evaluations;
 bool                seedPopulation;
+bool                adaptIncremental;
 bool                errorReduction;
 double              t_cc_rate;
 double              t_pc_rate;
@@ -144,6 +145,12 @@ void loadParameters(const ros::NodeHandle handle)
     std::cout<<"\nseed_population: "<<seedPopulation;
   }
   
+  if(handle.hasParam("ramp/adapt_incremental")) 
+  {
+    handle.getParam("ramp/adapt_incremental", adaptIncremental);
+    std::cout<<"\nadapt_incremental: "<<adaptIncremental;
+  }
+  
   if(handle.hasParam("ramp/gens_before_control_cycle")) 
   {
     handle.getParam("ramp/gens_before_control_cycle", gensBeforeCC);
@@ -206,6 +213,7 @@ int main(int argc, char** argv) {
   
   ros::Subscriber sub_update_ = handle.subscribe("update", 1, &Planner::updateCallback, &my_planner);
   ros::Subscriber sub_sc_ = handle.subscribe("obstacles", 1, &Planner::sensingCycleCallback, &my_planner);
+  ros::Subscriber sub_wd_ = handle.subscribe("watchdog_collision", 1, &Planner::watchdogCallback, &my_planner);
 
 
   // Load ros parameters
@@ -219,6 +227,7 @@ int main(int argc, char** argv) {
   my_planner.modifications_   = modifications;
   my_planner.evaluations_     = evaluations;
   my_planner.seedPopulation_  = seedPopulation;
+  my_planner.adaptIncremental_ = adaptIncremental;
 
   std::cout<<"\nStart: "<<my_planner.start_.toString();
   std::cout<<"\nGoal: "<<my_planner.goal_.toString();
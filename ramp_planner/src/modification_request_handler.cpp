@@ -1,12 +1,22 @@
 #include "modification_request_handler.h"
 
-ModificationRequestHandler::ModificationRequestHandler(const ros::NodeHandle& h) : handle_(h) 
-{
-  client_ = handle_.serviceClient<ramp_msgs::ModificationRequest>("/path_modification");
-}
+ModificationRequestHandler::ModificationRequestHandler(const ros::NodeHandle& h) : handle_(h), latencies_("path_modification"), 
+  client_(handle_, "/path_modification", latencies_) {}
 
 
 const bool ModificationRequestHandler::request(ramp_msgs::ModificationRequest& mr) 
 {
   return client_.call(mr);
 }
+
+
+std::future<bool> ModificationRequestHandler::requestAsync(ramp_msgs::ModificationRequest& mr)
+{
+  return std::async(std::launch::async, &ModificationRequestHandler::request, this, std::ref(mr));
+}
+
+
+const LatencyHistogram& ModificationRequestHandler::latencies() const
+{
+  return latencies_;
+}
@@ -8,6 +8,12 @@ Modifier::Modifier(const ros::NodeHandle& h, const unsigned int n) : num_ops(n),
 
 Modifier::~Modifier() 
 {
+  // The request thread uses the handler
+  if(pending_.valid())
+  {
+    pending_.wait();
+  }
+
   if(h_mod_req_ != 0) 
   {
     delete h_mod_req_;
@@ -148,26 +154,80 @@ const std::vector<Path> Modifier::perform(const Population& pop, bool imminent_c
   std::vector<Path> result;
  
   // Build a modification request srv 
-  ros::Time t_b = ros::Time::now();
   ramp_msgs::ModificationRequest mr;
   buildModificationRequest(pop, imminent_collision, mr); 
-  //////ROS_INFO("ModificationResult built, pop size: %i # of paths: %i", (int)pop.size(), (int)mr.response.mod_paths.size()); 
 
   //////ROS_INFO("Requesting modification");
   // If the request was successful
   if(h_mod_req_->request(mr)) 
   {
-    //////ROS_INFO("Got modification");
-    ros::Time t_m = ros::Time::now();
-    
-    // Push on the modified paths
-    for(unsigned int i=0;i<mr.response.mod_paths.size();i++) 
-    {
-      Path temp(mr.response.mod_paths.at(i));
-      result.push_back(temp);
-    }
-  } // end inner if 
+    getModifiedPaths(mr, result);
+  }
 
   //////ROS_INFO("Exiting Modifier::perform");
   return result;
 }
+
+
+/** Build a modification request from pop and send it, pop may change once this returns */
+void Modifier::startPerform(const Population& pop, bool imminent_collision)
+{
+  //////ROS_INFO("In Modifier::startPerform");
+  if(pending_.valid())
+  {
+    pending_.wait();
+  }
+
+  // Build a modification request srv 
+  mr_pending_ = ramp_msgs::ModificationRequest();
+  buildModificationRequest(pop, imminent_collision, mr_pending_); 
+
+  //////ROS_INFO("Requesting modification");
+  pending_ = h_mod_req_->requestAsync(mr_pending_);
+}
+
+
+/** True between startPerform and finishPerform */
+const bool Modifier::performing() const
+{
+  return pending_.valid();
+}
+
+
+/** Wait for the request sent by startPerform and return the modified paths */
+const std::vector<Path> Modifier::finishPerform()
+{
+  std::vector<Path> result;
+  if(!pending_.valid())
+  {
+    return result;
+  }
+
+  // If the request was successful
+  if(pending_.get()) 
+  {
+    getModifiedPaths(mr_pending_, result);
+  }
+
+  //////ROS_INFO("Exiting Modifier::finishPerform");
+  return result;
+}
+
+
+void Modifier::getModifiedPaths(const ramp_msgs::ModificationRequest& mr, std::vector<Path>& result) const
+{
+  //////ROS_INFO("Got modification");
+  
+  // Push on the modified paths
+  for(unsigned int i=0;i<mr.response.mod_paths.size();i++) 
+  {
+    Path temp(mr.response.mod_paths.at(i));
+    result.push_back(temp);
+  }
+}
+
+
+const LatencyHistogram& Modifier::latencies() const
+{
+  return h_mod_req_->latencies();
+}
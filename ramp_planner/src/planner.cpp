@@ -7,7 +7,7 @@
 
 Planner::Planner() : resolutionRate_(1.f / 10.f), ob_dists_timer_dur_(0.1), generation_(0), i_rt(1), goalThreshold_(0.4), num_ops_(6), D_(1.5f), 
   cc_started_(false), c_pc_(0), transThreshold_(1./50.), num_cc_(0), L_(0.33), h_traj_req_(0), h_eval_req_(0), h_control_(0), modifier_(0), 
- delta_t_switch_(0.1), stop_(false), moving_on_coll_(false), log_enter_exit_(true), log_switching_(true)
+ delta_t_switch_(0.1), stop_(false), moving_on_coll_(false), log_enter_exit_(true), log_switching_(true), adaptIncremental_(false), num_adapt_heads_(0), num_adapt_spliced_(0), ob_list_version_(0), watchdog_collision_(false), ec_offset_since_eval_(0)
 {
   imminentCollisionCycle_ = ros::Duration(1.f / 20.f);
   generationsPerCC_       = controlCycle_.toSec() / planningCycle_.toSec();
@@ -239,9 +239,20 @@ void Planner::sensingCycleCallback(const ramp_msgs::ObstacleList& msg)
     }
   }*/
 
+  // If the obstacles have not changed since the last list, their predictions can be reused
+  // Version 0 means the sender does not set versions
+  bool same_obs = msg.version != 0 && msg.version == ob_list_version_;
+  ob_list_version_ = msg.version;
+
   // For each obstacle, predict its trajectory
   for(uint8_t i=0;i<msg.obstacles.size();i++)
   {
+    if(same_obs && i < ob_trajectory_.size())
+    {
+      copy.trajectories_.push_back(ob_trajectory_.at(i));
+      continue;
+    }
+
     RampTrajectory ob_temp_trj = getPredictedTrajectory(msg.obstacles.at(i));
     if(ob_trajectory_.size() < i+1)
     {
@@ -281,17 +292,13 @@ void Planner::sensingCycleCallback(const ramp_msgs::ObstacleList& msg)
     moving_on_coll_ = !movingOn_.msg_.feasible;
   }
 
+  buildObIndex(msg.obstacles.size());
+
   // Find direction of closest obstacle for "move" operator
-  if(ob_trajectory_.size() > 0)
+  if(ob_index_.size() > 0)
   {
-    uint8_t i_closest=0;
-    for(uint8_t i=1;i<msg.obstacles.size();i++)
-    {
-      if(fabs(utility_.positionDistance(latestUpdate_.msg_.positions, ob_trajectory_.at(i).msg_.trajectory.points.at(0).positions)) < fabs(utility_.positionDistance(latestUpdate_.msg_.positions, ob_trajectory_.at(i_closest).msg_.trajectory.points.at(0).positions)))
-      {
-        i_closest = i; 
-      }
-    }
+    double d_closest;
+    uint8_t i_closest = ob_index_.nearest(latestUpdate_.msg_.positions.at(0), latestUpdate_.msg_.positions.at(1), d_closest);
     ROS_INFO("Closest ob: %s", utility_.toString(ob_trajectory_.at(i_closest).msg_.trajectory.points[0]).c_str());
 
     double dir = utility_.findAngleFromAToB(latestUpdate_.msg_.positions, 
@@ -967,6 +974,10 @@ void Planner::adaptPopulation(const MotionState& ms, const ros::Duration& d)
   
   // Create the vector to hold updated trajectories
   std::vector<ramp_msgs::TrajectoryRequest> tr_reqs;
+
+  // Whole paths in case a head does not splice, requested in the same batch as the heads
+  std::vector<ramp_msgs::TrajectoryRequest> full_reqs;
+  std::vector<uint16_t> i_full;
   
   ////ROS_INFO("paths.size(): %i curves.size(): %i", (int)paths.size(), (int)curves.size());
   // For each path, get a trajectory request
@@ -981,18 +992,60 @@ void Planner::adaptPopulation(const MotionState& ms, const ros::Duration& d)
       c.push_back(curves.at(i));
     }
 
+    // If adapting incrementally, only request the start of the path
+    Path head;
     ramp_msgs::TrajectoryRequest tr;
-    buildTrajectoryRequest(paths.at(i), c, tr);
-    tr.segments = 2;
+    if(adaptIncremental_ && getAdaptHead(paths.at(i), head))
+    {
+      buildTrajectoryRequest(head, c, tr);
+      tr.segments = 2;
+
+      ramp_msgs::TrajectoryRequest full = tr;
+      full.path = paths.at(i).buildPathMsg();
+      full_reqs.push_back(full);
+      i_full.push_back(i);
+    }
+    else
+    {
+      buildTrajectoryRequest(paths.at(i), c, tr);
+      tr.segments = 2;
+    }
 
     tr_reqs.push_back(tr);
   }
+  tr_reqs.insert(tr_reqs.end(), full_reqs.begin(), full_reqs.end());
   //ROS_INFO("tr_reqs.size(): %i", (int)tr_reqs.size());
   
   // Get the new trajectories
   std::vector<RampTrajectory> updatedTrajecs;
   requestTrajectory(tr_reqs, updatedTrajecs);
 
+  // Put the rest of the old trajectories back on the regenerated heads, 
+  // or use the whole path if the old trajectory does not continue from the head
+  if(updatedTrajecs.size() == tr_reqs.size())
+  {
+    for(uint16_t i=0;i<i_full.size();i++)
+    {
+      uint16_t i_pop = i_full.at(i);
+      RampTrajectory spliced;
+      if(spliceTail(updatedTrajecs.at(i_pop), population_.get(i_pop), paths.at(i_pop), spliced))
+      {
+        updatedTrajecs.at(i_pop) = spliced;
+        num_adapt_spliced_++;
+      }
+      else
+      {
+        updatedTrajecs.at(i_pop) = updatedTrajecs.at(tr_reqs.size() - i_full.size() + i);
+      }
+    } // end for
+    num_adapt_heads_ += i_full.size();
+  } // end if
+
+  if(updatedTrajecs.size() > paths.size())
+  {
+    updatedTrajecs.resize(paths.size());
+  }
+
   //ROS_INFO("updatedTrajecs.size(): %i", (int)updatedTrajecs.size());
 
   for(uint16_t i=0;i<updatedTrajecs.size();i++)
@@ -1022,6 +1075,111 @@ void Planner::adaptPopulation(const MotionState& ms, const ros::Duration& d)
 
 
 
+/*
+ * The head is the new start and the next ADAPT_HEAD_KNOTS-1 knot points,
+ * which covers the curve that adaptCurves updates. Returns false if the
+ * path is too short to have anything after the head
+ */
+const bool Planner::getAdaptHead(const Path& path, Path& result) const
+{
+  if(path.size() <= ADAPT_HEAD_KNOTS)
+  {
+    return false;
+  }
+
+  ramp_msgs::Path p;
+  p.points.insert(p.points.end(), path.msg_.points.begin(), path.msg_.points.begin()+ADAPT_HEAD_KNOTS);
+  result = Path(p);
+
+  return true;
+} // End getAdaptHead
+
+
+
+
+/*
+ * Finds the knot point of old that the last point of head arrives at and
+ * appends the points, knot points, and curves of old after it to head.
+ * The times of the appended points are shifted so they follow head.
+ * Returns false if no knot point of old matches the position and velocity
+ * at the end of head, in which case the trajectory has to be regenerated
+ */
+const bool Planner::spliceTail(const RampTrajectory& head, const RampTrajectory& old, const Path& path, RampTrajectory& result) const
+{
+  if(head.msg_.trajectory.points.size() == 0 || old.msg_.trajectory.points.size() == 0)
+  {
+    return false;
+  }
+
+  const trajectory_msgs::JointTrajectoryPoint& last = head.msg_.trajectory.points.at(
+      head.msg_.trajectory.points.size()-1);
+
+  // Find the knot point in old
+  int k_old = -1;
+  for(uint16_t i=1;i<old.msg_.i_knotPoints.size();i++)
+  {
+    const trajectory_msgs::JointTrajectoryPoint& p = old.msg_.trajectory.points.at(old.msg_.i_knotPoints.at(i));
+    if(utility_.positionDistance(last.positions, p.positions) < ADAPT_SPLICE_THRESHOLD &&
+        utility_.positionDistance(last.velocities, p.velocities) < ADAPT_SPLICE_THRESHOLD)
+    {
+      k_old = i;
+      break;
+    }
+  }
+
+  if(k_old == -1)
+  {
+    return false;
+  }
+
+  result = head;
+  result.msg_.holonomic_path = path.buildPathMsg();
+
+  uint16_t i_start  = old.msg_.i_knotPoints.at(k_old);
+  uint16_t i_offset = head.msg_.trajectory.points.size()-1;
+  ros::Duration t_offset = last.time_from_start - old.msg_.trajectory.points.at(i_start).time_from_start;
+
+  // Points
+  result.msg_.trajectory.points.reserve(i_offset + old.msg_.trajectory.points.size() - i_start);
+  for(uint16_t i=i_start+1;i<old.msg_.trajectory.points.size();i++)
+  {
+    trajectory_msgs::JointTrajectoryPoint p = old.msg_.trajectory.points.at(i);
+    p.time_from_start += t_offset;
+    result.msg_.trajectory.points.push_back(p);
+  }
+
+  // Knot points
+  for(uint16_t i=k_old+1;i<old.msg_.i_knotPoints.size();i++)
+  {
+    result.msg_.i_knotPoints.push_back(old.msg_.i_knotPoints.at(i) - i_start + i_offset);
+  }
+
+  // Curves that start past the head, their corners are knot points of path after the head
+  for(uint8_t c=0;c<old.msg_.curves.size();c++)
+  {
+    const ramp_msgs::BezierCurve& curve = old.msg_.curves.at(c);
+    if(curve.segmentPoints.size() < 3)
+    {
+      continue;
+    }
+
+    for(uint16_t i=ADAPT_HEAD_KNOTS;i<path.size();i++)
+    {
+      if(utility_.positionDistance(curve.segmentPoints.at(1).positions, 
+            path.msg_.points.at(i).motionState.positions) < ADAPT_SPLICE_THRESHOLD)
+      {
+        result.msg_.curves.push_back(curve);
+        break;
+      }
+    }
+  } // end for
+
+  return true;
+} // End spliceTail
+
+
+
+
 // Build a srv for 1 trajectory with 1-2 curves
 void Planner::buildTrajectorySrv(const Path path, const std::vector<ramp_msgs::BezierCurve> curves, ramp_msgs::TrajectorySrv& result, const int id) const
 {
@@ -1184,44 +1342,73 @@ void Planner::requestTrajectory(ramp_msgs::TrajectorySrv& tr, std::vector<RampTr
   if(h_traj_req_->request(tr)) 
   {
     trajec_durs_.push_back(ros::Time::now() - t_start);
-    
-    //ROS_INFO("tr.request.reqs.size(): %i", (int)tr.request.reqs.size());
-    //ROS_INFO("tr.resps.size(): %i", (int)tr.response.resps.size());
-    for(uint8_t i=0;i<tr.response.resps.size();i++)
-    {
-      RampTrajectory temp;
+    getTrajectoriesFromSrv(tr, result, id);
+  } // end if
+  else 
+  {
+    ROS_ERROR("Requesting %i trajectories failed", (int)tr.request.reqs.size());
+  }
 
-      // Set the actual trajectory msg
-      temp.msg_             = tr.response.resps.at(i).trajectory;
+  //////ROS_INFO("Exiting Planner::requestTrajectory, t_start: %f", result.msg_.t_start.toSec());
+}
 
-      // Set things the traj_gen does not have
-      temp.msg_.t_start     = ros::Duration(t_fixed_cc_);
 
-      // Set the paths (straight-line and bezier)
-      temp.msg_.holonomic_path  = tr.request.reqs.at(i).path;
+/** Start generating the trajectory of p, tr must not be used until the future is ready */
+std::future<bool> Planner::requestTrajectoryAsync(const Path& p, ramp_msgs::TrajectorySrv& tr)
+{
+  tr = ramp_msgs::TrajectorySrv();
+  buildTrajectorySrv(p, tr);
+  return h_traj_req_->requestAsync(tr);
+}
 
-      // Set the ID of the trajectory
-      if(id != -1) 
-      {
-        temp.msg_.id = id;
-      }
-      else 
-      {
-        temp.msg_.id = getIRT();
-      }
 
-      result.push_back(temp);
-    } // end for
-  } // end if
-  else 
+/** Wait for a request started by requestTrajectoryAsync, result is empty if it failed */
+void Planner::finishTrajectoryRequest(std::future<bool>& pending, ramp_msgs::TrajectorySrv& tr, std::vector<RampTrajectory>& result, const int id)
+{
+  if(pending.get())
   {
-    ////ROS_ERROR("An error occurred when requesting a trajectory");
+    getTrajectoriesFromSrv(tr, result, id);
+  }
+  else
+  {
+    ROS_ERROR("Requesting %i trajectories failed", (int)tr.request.reqs.size());
   }
-
-  //////ROS_INFO("Exiting Planner::requestTrajectory, t_start: %f", result.msg_.t_start.toSec());
 }
 
 
+/** Build the RampTrajectories of a TrajectorySrv's response */
+void Planner::getTrajectoriesFromSrv(const ramp_msgs::TrajectorySrv& tr, std::vector<RampTrajectory>& result, const int id)
+{
+  //ROS_INFO("tr.request.reqs.size(): %i", (int)tr.request.reqs.size());
+  //ROS_INFO("tr.resps.size(): %i", (int)tr.response.resps.size());
+  for(uint8_t i=0;i<tr.response.resps.size();i++)
+  {
+    RampTrajectory temp;
+
+    // Set the actual trajectory msg
+    temp.msg_             = tr.response.resps.at(i).trajectory;
+
+    // Set things the traj_gen does not have
+    temp.msg_.t_start     = ros::Duration(t_fixed_cc_);
+
+    // Set the paths (straight-line and bezier)
+    temp.msg_.holonomic_path  = tr.request.reqs.at(i).path;
+
+    // Set the ID of the trajectory
+    if(id != -1) 
+    {
+      temp.msg_.id = id;
+    }
+    else 
+    {
+      temp.msg_.id = getIRT();
+    }
+
+    result.push_back(temp);
+  } // end for
+} // End getTrajectoriesFromSrv
+
+
 
 
 void Planner::requestTrajectory(std::vector<ramp_msgs::TrajectoryRequest>& trs, std::vector<RampTrajectory>& result)
@@ -1280,6 +1467,21 @@ void Planner::setT_base_w(std::vector<double> base_pos)
 const unsigned int Planner::getIRT() { return i_rt++; }
 
 
+/** Index the current position of the first num_obs obstacles */
+void Planner::buildObIndex(const uint8_t num_obs)
+{
+  ob_index_.clear();
+  ob_index_.setCellSize(OB_INDEX_CELL_SIZE);
+  for(uint8_t i=0;i<num_obs && i<ob_trajectory_.size();i++)
+  {
+    const std::vector<double>& p = ob_trajectory_.at(i).msg_.trajectory.points.at(0).positions;
+    ob_index_.insert(i, p.at(0), p.at(1));
+  }
+  ob_index_.build();
+} // End buildObIndex
+
+
+
 void Planner::obICCallback(const ros::TimerEvent& e)
 {
   ////ROS_INFO("Time since last obICCallback: %f", (ros::Time::now() - t_prevObIC_).toSec());
@@ -1292,6 +1494,7 @@ void Planner::obICCallback(const ros::TimerEvent& e)
   if(ob_trajectory_.size() > 0)
     min_dist = utility_.positionDistance(ob_trajectory_.at(0).msg_.trajectory.points.at(0).positions, latestUpdate_.msg_.positions);
  
+  std::vector<int> near_obs;
   for(uint8_t i=0;i<ob_trajectory_.size();i++)
   {
     double dist = utility_.positionDistance(ob_trajectory_.at(i).msg_.trajectory.points.at(0).positions, latestUpdate_.msg_.positions);
@@ -1323,19 +1526,15 @@ void Planner::obICCallback(const ros::TimerEvent& e)
     }
 
     // Now check dist from other obs
-    for(int j=0;j<ob_trajectory_.size();j++)
+    const std::vector<double>& p = ob_trajectory_.at(i).msg_.trajectory.points.at(0).positions;
+    ob_index_.radius(p.at(0), p.at(1), dist_theshold, near_obs);
+    for(int j=0;j<near_obs.size() && !ob_ic.data;j++)
     {
-      if(j != i)
+      if(near_obs[j] != i)
       {
-        double dist_ob = utility_.positionDistance(ob_trajectory_.at(i).msg_.trajectory.points.at(0).positions, ob_trajectory_.at(j).msg_.trajectory.points.at(0).positions);
-
-        if(dist_ob < dist_theshold)
-        {
-          ob_ic.data = true;
-          break;
-        } // end if dist < dist_threshold
-      } // end if i != j
-    } // end for each other obstacle
+        ob_ic.data = true;
+      }
+    } // end for each nearby obstacle
     
     // Send IC data
     h_control_->sendObIC(i, ob_ic);
@@ -1388,9 +1587,10 @@ void Planner::imminentCollisionCallback(const ros::TimerEvent& t)
     ROS_INFO("Ob %i: %f", o, utility_.positionDistance(latestUpdate_.msg_.positions, ob_trajectory_[o].msg_.trajectory.points[0].positions));
   }
 
-  if(ob_trajectory_.size() > 0 && moving_on_coll_ && (movingOn_.msg_.t_firstCollision.toSec() < time_threshold
-    || (movingOn_.msg_.t_firstCollision.toSec() - (ros::Time::now().toSec()-t_prevCC_.toSec())) < time_threshold))
+  if(watchdog_collision_ || (ob_trajectory_.size() > 0 && moving_on_coll_ && (movingOn_.msg_.t_firstCollision.toSec() < time_threshold
+    || (movingOn_.msg_.t_firstCollision.toSec() - (ros::Time::now().toSec()-t_prevCC_.toSec())) < time_threshold)))
   {
+    ROS_WARN("IC: watchdog_collision_: %s", watchdog_collision_ ? "True" : "False");
     ROS_WARN("IC: moving_on_coll_: %s t_firstCollision: %f Elapsed time: %f", moving_on_coll_ ? "True" : "False", movingOn_.msg_.t_firstCollision.toSec(), (ros::Time::now().toSec()-t_prevCC_.toSec()));
     
     // Check if IC was previously false
@@ -1425,6 +1625,19 @@ void Planner::imminentCollisionCallback(const ros::TimerEvent& t)
 
 
 
+/** Sets watchdog_collision_, the next imminentCollisionCallback acts on it */
+void Planner::watchdogCallback(const std_msgs::Bool& msg)
+{
+  if(msg.data != watchdog_collision_)
+  {
+    ROS_WARN("Watchdog collision: %s", msg.data ? "True" : "False");
+  }
+  watchdog_collision_ = msg.data;
+}
+
+
+
+
 /** 
  * Sets the latest update member
  * and transformes it by T_base_w because 
@@ -1445,7 +1658,8 @@ void Planner::updateCallback(const ramp_msgs::MotionState& msg)
   }
   else 
   {
-    latestUpdate_ = msg;
+    latestUpdate_     = msg;
+    t_latest_update_  = t_prev_update_;
 
     // Transform configuration from odometry to world coordinates
     latestUpdate_.transformBase(T_w_odom_);
@@ -1470,6 +1684,36 @@ void Planner::updateCallback(const ramp_msgs::MotionState& msg)
 
 
 
+/**
+ * Extrapolate latestUpdate_ to t, each DOF moves with constant acceleration 
+ * from the time the update was received
+ * ramp_control sends states extrapolated to when they are sent, so this only 
+ * has to cover the time since then
+ */
+const MotionState Planner::getPredictedState(const ros::Time& t) const
+{
+  MotionState result = latestUpdate_;
+
+  double dt = (t - t_latest_update_).toSec();
+  if(t_latest_update_.isZero() || dt <= 0 || result.msg_.positions.size() < 3 || 
+      result.msg_.velocities.size() < 3 || result.msg_.accelerations.size() < 3)
+  {
+    return result;
+  }
+  dt = dt > UPDATE_MAX_EXTRAPOLATION ? UPDATE_MAX_EXTRAPOLATION : dt;
+
+  for(uint8_t i=0;i<3;i++)
+  {
+    result.msg_.positions.at(i)  += result.msg_.velocities.at(i)*dt + 0.5*result.msg_.accelerations.at(i)*dt*dt;
+    result.msg_.velocities.at(i) += result.msg_.accelerations.at(i)*dt;
+  }
+  result.msg_.positions.at(2) = utility_.displaceAngle(result.msg_.positions.at(2), 0);
+
+  return result;
+} // End getPredictedState
+
+
+
 
 
 
@@ -2518,78 +2762,66 @@ void Planner::getTransitionTrajectory(const RampTrajectory& trj_movingOn, const
 const std::vector<Path> Planner::modifyPath() 
 { 
   ROS_INFO("About to modify a path, pop is: %s\n%s", population_.get(0).toString().c_str(), population_.get(1).toString().c_str());
-  return modifier_->perform(population_, imminent_collision_);
-}
-
-
-
-void Planner::modifyTrajec(std::vector<RampTrajectory>& result)
-{
-  //////ROS_INFO("In Planner::modifyTrajec");
 
-  // The process begins by modifying one or more paths
-  ros::Time t_p = ros::Time::now();
-  std::vector<Path> modded_paths = modifyPath();
-  ////ROS_INFO("Number of modified paths: %i", (int)modded_paths.size());
-
-
-  ros::Time t_for = ros::Time::now();
-  // For each targeted path,
-  for(unsigned int i=0;i<modded_paths.size();i++) 
+  // The request may already be out, see planningCycleCallback
+  if(!modifier_->performing())
   {
-    //std::cout<<"\nramp_planner: Modifying trajectory "<<(int)i;
-    
-    // Get trajectory
-    //RampTrajectory temp = requestTrajectory(modded_paths.at(i));
-    ros::Time t_for = ros::Time::now();
-    RampTrajectory traj;
-    requestTrajectory(modded_paths[i], traj);
-    result.push_back(traj);
-    ros::Time t_a = ros::Time::now();
-    ////ROS_INFO("t_mod_oop: %f", (t_a-t_for).toSec());
-  } // end for
-  
-  //////ROS_INFO("Exiting Planner::modifyTrajec");
+    modifier_->startPerform(population_, imminent_collision_);
+  }
+  return modifier_->finishPerform();
 }
 
 
 
-
-
-
 void Planner::modification()
 {
   ros::Time t_m = ros::Time::now();
   ROS_INFO("In Planner::modification()");
   ModificationResult result;
 
-  // Modify 1 or more trajectories
-  ros::Time now = ros::Time::now();
-  std::vector<RampTrajectory> mod_trajec;
-  modifyTrajec(mod_trajec);
-  ros::Time t_p = ros::Time::now();
-  ////ROS_INFO("t_p: %f", (t_p-now).toSec());
-  ////ROS_INFO("Modification trajectories obtained: %i", (int)mod_trajec.size());
+  // Modify 1 or more paths
+  std::vector<Path> modded_paths = modifyPath();
+  ////ROS_INFO("Modified paths obtained: %i", (int)modded_paths.size());
   
-  if(mod_trajec.size()>1)
+  if(modded_paths.size()>1)
     modded_two=true;
 
-  ros::Time t_for = ros::Time::now();
+  // Generate the trajectory of the next path while the current one is evaluated, 
+  // so the generator and the evaluator work at the same time
+  ramp_msgs::TrajectorySrv tr_srvs[2];
+  std::future<bool> generating;
+  if(modded_paths.size() > 0)
+  {
+    generating = requestTrajectoryAsync(modded_paths[0], tr_srvs[0]);
+  }
+
   // Evaluate and add the modified trajectories to the population
   // and update the planner and the modifier on the new paths
-  for(unsigned int i=0;i<mod_trajec.size();i++) 
+  for(unsigned int i=0;i<modded_paths.size();i++) 
   {
+    std::vector<RampTrajectory> mod_trajec;
+    finishTrajectoryRequest(generating, tr_srvs[i%2], mod_trajec);
+    if(i+1 < modded_paths.size())
+    {
+      generating = requestTrajectoryAsync(modded_paths[i+1], tr_srvs[(i+1)%2]);
+    }
+
+    if(mod_trajec.size() == 0)
+    {
+      continue;
+    }
+
     //ROS_INFO("i: %i", i);
-    ROS_INFO("Modified trajectory: %s", mod_trajec.at(i).toString().c_str());
+    ROS_INFO("Modified trajectory: %s", mod_trajec.at(0).toString().c_str());
     ROS_INFO("controlCycle_.toSec(): %f", controlCycle_.toSec());
     //////ROS_INFO("Path size: %i", (int)mod_trajec[i].msg_.holonomic_path.points.size());
     //std::cout<<"\nramp_planner: Evaluating trajectory "<<(int)i<<"\n";
 
     // Compute full switch (method evaluates the trajectory)
-    RampTrajectory traj_final = mod_trajec[i];
+    RampTrajectory traj_final = mod_trajec[0];
     if(cc_started_)
     {
-      computeFullSwitch(movingOn_, mod_trajec[i], controlCycle_.toSec(), traj_final);
+      computeFullSwitch(movingOn_, mod_trajec[0], controlCycle_.toSec(), traj_final);
     }
     else
     {
@@ -2717,8 +2949,9 @@ const MotionState Planner::errorCorrection()
   ros::Duration t_since_cc = ros::Time::now() - t_prevCC_;
   //MotionState diff = m_i_.at(t_since_cc.toSec()).subtractPosition(latestUpdate_, true);
   MotionState diff = movingOnCC_.getPointAtTime(t_since_cc.toSec());
+  MotionState current = getPredictedState(ros::Time::now());
   //////ROS_INFO("Diff before subtract: %s", diff.toString().c_str());
-  diff = diff.subtractPosition(latestUpdate_, true);
+  diff = diff.subtractPosition(current, true);
   MotionState temp = diff_.subtractPosition(diff);
   //////ROS_INFO("Diff after subtract: %s", diff.toString().c_str());
   
@@ -2733,7 +2966,7 @@ const MotionState Planner::errorCorrection()
   result = m_cc_.subtractPosition(temp, true);
 
   // Set new theta
-  result.msg_.positions.at(2) = latestUpdate_.msg_.positions.at(2);
+  result.msg_.positions.at(2) = current.msg_.positions.at(2);
 
 
   //////ROS_INFO("result: %s", result.toString().c_str());
@@ -2790,11 +3023,14 @@ void Planner::planningCycleCallback()
       diff = movingOnCC_.getPointAtTime(t_since_cc.toSec());
       //diff = movingOn_.getPointAtTime(t_since_cc.toSec());
       
+      // Compare with the state the robot is at now, not when the update was sent
+      MotionState current = getPredictedState(ros::Time::now());
+
       ROS_INFO("movingOnCC_ at t_since_cc: %s", diff.toString().c_str());
-      ROS_INFO("latestUpdate_: %s", latestUpdate_.toString().c_str());
+      ROS_INFO("latestUpdate_: %s current: %s", latestUpdate_.toString().c_str(), current.toString().c_str());
 
       // Find offset for thisPC
-      diff = diff.subtractPosition(latestUpdate_, true);
+      diff = diff.subtractPosition(current, true);
       MotionState temp = diff_.subtractPosition(diff);
       
       // diff_ is the overall offset of pop since last CC
@@ -2812,7 +3048,19 @@ void Planner::planningCycleCallback()
 
       offsetPopulation(temp);
 
-      evaluatePopulation();
+      // The modification request only needs the corrected paths, 
+      // the modifier works on it while the population is evaluated
+      if(modifications_)
+      {
+        modifier_->startPerform(population_, imminent_collision_);
+      }
+
+      // Small offsets barely change the fitness, only evaluate once they add up
+      ec_offset_since_eval_ += temp.normPosition();
+      if(ec_offset_since_eval_ > EC_EVALUATE_THRESHOLD)
+      {
+        evaluatePopulation();
+      }
 
       ROS_INFO("Pop after adjustment: %s", population_.toString().c_str());
 
@@ -3482,6 +3730,19 @@ void Planner::displayTrajectory(const ramp_msgs::RampTrajectory traj) const
 
 
 
+/**
+ * Without a result the trajectory would keep the fitness of its last 
+ * evaluation, which may have been before it was modified or the obstacles
+ * moved. Give it the worst fitness and a collision now instead
+ */
+void Planner::setEvaluationFailed(ramp_msgs::RampTrajectory& trj) const
+{
+  trj.fitness           = 0;
+  trj.feasible          = false;
+  trj.t_firstCollision  = ros::Duration(0);
+} // End setEvaluationFailed
+
+
 void Planner::requestEvaluation(std::vector<RampTrajectory>& trajecs) 
 {
   ramp_msgs::EvaluationSrv srv;
@@ -3508,7 +3769,11 @@ void Planner::requestEvaluation(std::vector<RampTrajectory>& trajecs)
   }
   else
   {
-    ////ROS_ERROR("An error occurred when evaluating a trajectory");
+    ROS_ERROR("Evaluating %i trajectories failed, marking them infeasible", (int)trajecs.size());
+    for(uint16_t i=0;i<trajecs.size();i++)
+    {
+      setEvaluationFailed(trajecs[i].msg_);
+    }
   }
 }
 
@@ -3528,7 +3793,8 @@ void Planner::requestEvaluation(ramp_msgs::EvaluationRequest& request) const
   }
   else
   {
-    ////ROS_ERROR("An error occurred when evaluating a trajectory");
+    ROS_ERROR("Evaluating a trajectory failed, marking it infeasible");
+    setEvaluationFailed(request.trajectory);
   }
   ////ROS_INFO("Exiting Planner::requestEvaluation(EvaluationRequest&)");
 }
@@ -3563,6 +3829,7 @@ void Planner::evaluateTrajectory(RampTrajectory& t, bool full) const
 
 void Planner::evaluatePopulation()
 {
+  ec_offset_since_eval_ = 0;
   requestEvaluation(population_.trajectories_);
   /*for(uint16_t i=0;i<population_.size();i++)
   {
@@ -3619,6 +3886,7 @@ void Planner::reportData()
   }
   avg_adapt_dur_ = sum / adapt_durs_.size();
   ROS_INFO("Average adaptation duration: %f", avg_adapt_dur_);
+  ROS_INFO("Adapted heads spliced: %i/%i", num_adapt_spliced_, num_adapt_heads_);
 
 
   sum = 0.;
@@ -3702,6 +3970,10 @@ void Planner::reportData()
   avg_eval_dur_ = sum / eval_durs_.size();
   ROS_INFO("Average eval duration: %f", avg_eval_dur_);
 
+  ROS_INFO("%s", h_traj_req_->latencies().toString().c_str());
+  ROS_INFO("%s", h_eval_req_->latencies().toString().c_str());
+  ROS_INFO("%s", modifier_->latencies().toString().c_str());
+
 
   sum = 0.;
   for(uint16_t i=0;i<error_correct_val_pos_.size();i++)
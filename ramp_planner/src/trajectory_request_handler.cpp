@@ -1,13 +1,23 @@
 #include "trajectory_request_handler.h"
 
 
-TrajectoryRequestHandler::TrajectoryRequestHandler(const ros::NodeHandle& h) : handle_(h) 
-{
-  client_ = handle_.serviceClient<ramp_msgs::TrajectorySrv>("/trajectory_generator");
-}
+TrajectoryRequestHandler::TrajectoryRequestHandler(const ros::NodeHandle& h) : handle_(h), latencies_("trajectory_generator"), 
+  client_(handle_, "/trajectory_generator", latencies_) {}
 
 
 const bool TrajectoryRequestHandler::request(ramp_msgs::TrajectorySrv& tr) 
 {
   return client_.call(tr);
 }
+
+
+std::future<bool> TrajectoryRequestHandler::requestAsync(ramp_msgs::TrajectorySrv& tr)
+{
+  return std::async(std::launch::async, &TrajectoryRequestHandler::request, this, std::ref(tr));
+}
+
+
+const LatencyHistogram& TrajectoryRequestHandler::latencies() const
+{
+  return latencies_;
+}
@@ -35,6 +35,7 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <nav_msgs/OccupancyGrid.h>
+#include <vector>
 
 
 
@@ -120,6 +121,26 @@ public:
   ///@brief Recalculate the internal distance map. Required after manual changes to the grid map data.
   void updateDistanceMap();
 
+  /**
+   * @brief Recalculate the clearance pyramid, required before the clearance queries.
+   * Level 0 holds the clearance of each cell (distance in m to the closest occupied cell),
+   * each level above halves the resolution and stores the min clearance of the cells it covers,
+   * so a coarse cell is a lower bound for everything under it.
+   * Changing the map clears the pyramid.
+   */
+  void updateClearancePyramid(unsigned int levels = 4);
+
+  /// Returns the min clearance (in m) of the points within radius of <wx,wy>; -1 if out of bounds or no pyramid
+  float minClearanceInDisk(double wx, double wy, double radius) const;
+
+  /// Returns the min clearance (in m) of the cells along the segment <wx0,wy0> - <wx1,wy1>;
+  /// -1 if the segment misses the map or there is no pyramid. Parts of the segment out of the map are ignored
+  float minClearanceAlongSegment(double wx0, double wy0, double wx1, double wy1) const;
+
+  /// @return true if every cell along the segment <wx0,wy0> - <wx1,wy1> has at least clearance (in m).
+  /// 		Coarse cells with enough clearance are not refined and the search stops at the first cell without it.
+  bool isSegmentClear(double wx0, double wy0, double wx1, double wy1, double clearance) const;
+
   inline const nav_msgs::MapMetaData& getInfo() const {return m_mapInfo;}
   inline float getResolution() const {return m_mapInfo.resolution; }
   /// returns the tf frame ID of the map (usually "/map")
@@ -128,6 +149,8 @@ public:
   const cv::Mat& distanceMap() const {return m_distMap;}
   /// @return the cv::Mat binary image.
   const cv::Mat& binaryMap() const {return m_binaryMap;}
+  /// @return the clearance pyramid, level 0 has the resolution of the map
+  const std::vector<cv::Mat>& clearancePyramid() const {return m_clearancePyramid;}
   /// @return the size of the cv::Mat binary image. Note that x/y are swapped wrt. height/width
   inline const CvSize size() const {return m_binaryMap.size();}
 
@@ -135,8 +158,20 @@ public:
   const static uchar OCCUPIED = 100; ///< char value for "free": 0
 
 protected:
+  /// Min clearance of the cells along a segment given in map coordinates (cells, not rounded).
+  /// Cells with a bound >= prune are skipped and the search stops once a clearance < stop is found.
+  /// Returns -1 if the segment misses the map
+  float searchSegment(double mx0, double my0, double mx1, double my1, float prune, float stop) const;
+
+  /// Check if the segment crosses the box of cells [x0, x1] x [y0, y1]
+  static bool segmentInBox(double mx0, double my0, double mx1, double my1, double x0, double y0, double x1, double y1);
+
+  /// Check if the segment crosses the map cells covered by cell <x,y> of a pyramid level
+  bool segmentInCells(double mx0, double my0, double mx1, double my1, int level, int x, int y) const;
+
   cv::Mat m_binaryMap;	///< binary occupancy map. 255: free, 0 occupied.
   cv::Mat m_distMap;		///< distance map (in meter)
+  std::vector<cv::Mat> m_clearancePyramid; ///< distance to the closest occupied cell (in meter), level i is 2^i cells per cell
   nav_msgs::MapMetaData m_mapInfo;
   std::string m_frameId;	///< "map" frame where ROS OccupancyGrid originated from
 
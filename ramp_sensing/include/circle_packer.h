@@ -8,6 +8,12 @@
 #include <queue>
 #include <visualization_msgs/Marker.h>
 
+// Cells with a higher occupancy are obstacles, same as GridMap2D
+#define OCC_THRESHOLD 70
+
+// Fewer contours than this are converted on the calling thread
+#define PARALLEL_MIN_CONTOURS 16
+
 struct Edge
 {
   cv::Point start;
@@ -61,9 +67,13 @@ struct CompareDist
 class CirclePacker 
 {
   public:
+    CirclePacker();
     CirclePacker(nav_msgs::OccupancyGridConstPtr);
     ~CirclePacker();
 
+    // Set the grid to pack, buffers are reused when the grid has the same size as the last one
+    void update(nav_msgs::OccupancyGridConstPtr);
+
     void convertOGtoMat(nav_msgs::OccupancyGridConstPtr);
 
     void CannyThreshold(int, void*);
@@ -78,7 +88,17 @@ class CirclePacker
     std::vector<visualization_msgs::Marker> getMarkers(const std::vector<Circle> cirs) const;
     
     std::vector<Circle> getCirclesFromPoly(Polygon);
-    std::vector<Circle> getCirclesFromEdgeSets(const std::vector< std::vector<Edge> > edge_sets);
+
+    // Same packing as getCirclesFromPoly, built on a distance transform of the polygon
+    // Only benchmark_packing uses it, go() packs with getCirclesFromEdgeSets
+    std::vector<Circle> getCirclesFromPolyDistances(const Polygon&);
+
+    // Greedily pack circles in the cells with a positive distance (in cells), centers are (col, row)
+    std::vector<Circle> getCirclesFromDistances(const cv::Mat& dist) const;
+    std::vector<Circle> getCirclesFromEdgeSets(const std::vector< std::vector<Edge> > edge_sets) const;
+
+    // Closed set of edges between consecutive contour points
+    std::vector<Edge> getEdgesFromContour(const std::vector<cv::Point>& contour) const;
     std::vector<Circle> getCirclesFromEdges(const std::vector<Edge> edges, const cv::Point robot_cen);
     
     std::vector<Triangle> triangulatePolygon(const Polygon&);
@@ -91,7 +111,10 @@ class CirclePacker
     cv::Mat src, src_gray;
     cv::Mat dst, detected_edges;
 
-    nav_msgs::OccupancyGrid grid_;
+    // Scratch space for go(), kept between calls
+    std::vector< std::vector<cv::Point> > contours_;
+    std::vector<cv::Vec4i> hierarchy_;
+    std::vector< std::vector<Circle> > contour_cirs_;
 
     std::vector<visualization_msgs::Marker> markers_;
 
@@ -104,4 +127,24 @@ class CirclePacker
 
 };
 
+
+/*
+ * Converts a range of contours to circles for cv::parallel_for_. Contours are 
+ * independent, each one only writes its own element of result so they can be
+ * merged in contour order afterwards
+ */
+class ContourToCircles : public cv::ParallelLoopBody
+{
+  public:
+    ContourToCircles(const CirclePacker& packer, const std::vector< std::vector<cv::Point> >& contours, 
+        std::vector< std::vector<Circle> >& result);
+
+    virtual void operator()(const cv::Range& range) const;
+
+  private:
+    const CirclePacker& packer_;
+    const std::vector< std::vector<cv::Point> >& contours_;
+    std::vector< std::vector<Circle> >& result_;
+};
+
 #endif
@@ -36,6 +36,9 @@ class Obstacle
 
     void update(const Circle c);
 
+    // Set the circle and the state estimated for it
+    void update(const Circle c, const ramp_msgs::MotionState& ms, const uint32_t id);
+
     void doTF();
 
   private:
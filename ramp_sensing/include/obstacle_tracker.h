@@ -0,0 +1,73 @@
+#ifndef OBSTACLE_TRACKER_H
+#define OBSTACLE_TRACKER_H
+#include "ros/ros.h"
+#include "ramp_msgs/MotionState.h"
+#include "circle_packer.h"
+
+
+/** Constant velocity Kalman filter for one axis, state is [position, velocity] */
+struct AxisFilter
+{
+  double p, v;
+  double P[2][2];
+};
+
+
+struct Track
+{
+  uint32_t id;
+
+  // x and y are independent with a constant velocity model
+  AxisFilter x, y;
+
+  // Last circle associated with the track, in map cells
+  Circle cir;
+
+  ros::Time last_seen;
+  int hits;
+  int misses;
+};
+
+
+/**
+ * Associates the circles of consecutive costmaps with greedy nearest neighbour 
+ * and gating, and estimates the velocity of each track with a Kalman filter.
+ * Circles are passed in world coordinates (meters) along with the circle in map
+ * cells that is kept for display
+ */
+class ObstacleTracker 
+{
+  public:
+    ObstacleTracker();
+    ~ObstacleTracker();
+
+    // Max distance (m) between a predicted track and a circle to associate them
+    double gate_;
+
+    // Std dev of the acceleration (m/s^2) and of the measured position (m)
+    double sigma_a_, sigma_z_;
+
+    // Number of costmaps a track is kept without being seen
+    int max_misses_;
+
+    // centers are the world positions of cirs
+    void update(const std::vector<Circle>& cirs, const std::vector<Point>& centers, const ros::Time& t);
+
+    // Tracks seen in the last update
+    void getVisibleTracks(std::vector<Track>& result) const;
+
+    // [x, y, heading] and [x_dot, y_dot, 0] of a track
+    const ramp_msgs::MotionState getMotionState(const Track& track) const;
+
+    const std::vector<Track>& tracks() const;
+
+  private:
+    std::vector<Track> tracks_;
+    uint32_t next_id_;
+
+    void initFilter(const double z, AxisFilter& f) const;
+    void predict(const double dt, AxisFilter& f) const;
+    void correct(const double z, AxisFilter& f) const;
+};
+
+#endif
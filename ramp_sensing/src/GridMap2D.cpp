@@ -30,9 +30,16 @@
 
 #include "GridMap2D.h"
 #include <ros/console.h>
+#include <algorithm>
+#include <limits>
 
 namespace gridmap_2d{
 
+/// Order pyramid cells by their clearance, lowest first
+static bool compareChildren(const std::pair<float, cv::Vec3i>& a, const std::pair<float, cv::Vec3i>& b){
+  return a.first < b.first;
+}
+
 GridMap2D::GridMap2D()
 : m_frameId("/map")
 {
@@ -51,7 +58,8 @@ GridMap2D::GridMap2D(const GridMap2D& other)
    m_mapInfo(other.m_mapInfo),
    m_frameId(other.m_frameId)
 {
-
+  for (unsigned int i = 0; i < other.m_clearancePyramid.size(); ++i)
+    m_clearancePyramid.push_back(other.m_clearancePyramid[i].clone());
 }
 
 GridMap2D::~GridMap2D() {
@@ -62,6 +70,151 @@ void GridMap2D::updateDistanceMap(){
   cv::distanceTransform(m_binaryMap, m_distMap, CV_DIST_L2, CV_DIST_MASK_PRECISE);
   // distance map now contains distance in meters:
   m_distMap = m_distMap * m_mapInfo.resolution;
+  m_clearancePyramid.clear();
+}
+
+void GridMap2D::updateClearancePyramid(unsigned int levels){
+  m_clearancePyramid.resize(std::max(levels, 1u));
+
+  // distanceTransform measures to the closest 0 cell, so occupied cells have to be 0
+  cv::Mat freeCells = (m_binaryMap == FREE);
+  cv::distanceTransform(freeCells, m_clearancePyramid[0], CV_DIST_L2, CV_DIST_MASK_PRECISE);
+  m_clearancePyramid[0] = m_clearancePyramid[0] * m_mapInfo.resolution;
+
+  // each cell of a level is the min of the (up to) 4 cells below it
+  for (unsigned int l = 1; l < m_clearancePyramid.size(); ++l){
+    const cv::Mat& below = m_clearancePyramid[l-1];
+    cv::Mat& level = m_clearancePyramid[l];
+    level = cv::Mat((below.rows+1) / 2, (below.cols+1) / 2, CV_32FC1);
+    for (int i = 0; i < level.rows; ++i){
+      for (int j = 0; j < level.cols; ++j){
+        float m = below.at<float>(2*i, 2*j);
+        if (2*i+1 < below.rows)
+          m = std::min(m, below.at<float>(2*i+1, 2*j));
+        if (2*j+1 < below.cols)
+          m = std::min(m, below.at<float>(2*i, 2*j+1));
+        if (2*i+1 < below.rows && 2*j+1 < below.cols)
+          m = std::min(m, below.at<float>(2*i+1, 2*j+1));
+        level.at<float>(i, j) = m;
+      }
+    }
+  }
+}
+
+float GridMap2D::minClearanceInDisk(double wx, double wy, double radius) const{
+  unsigned mx, my;
+  if (m_clearancePyramid.empty() || !worldToMap(wx, wy, mx, my))
+    return -1.0f;
+
+  // clearance is a distance field, it can't drop faster than the distance from the center
+  return std::max(0.0, m_clearancePyramid[0].at<float>(mx, my) - radius);
+}
+
+float GridMap2D::minClearanceAlongSegment(double wx0, double wy0, double wx1, double wy1) const{
+  if (m_clearancePyramid.empty())
+    return -1.0f;
+
+  const double res = m_mapInfo.resolution;
+  return searchSegment((wx0 - m_mapInfo.origin.position.x) / res, (wy0 - m_mapInfo.origin.position.y) / res,
+                       (wx1 - m_mapInfo.origin.position.x) / res, (wy1 - m_mapInfo.origin.position.y) / res,
+                       std::numeric_limits<float>::max(), -1.0f);
+}
+
+bool GridMap2D::isSegmentClear(double wx0, double wy0, double wx1, double wy1, double clearance) const{
+  if (m_clearancePyramid.empty())
+    return false;
+
+  const double res = m_mapInfo.resolution;
+  float minClearance = searchSegment((wx0 - m_mapInfo.origin.position.x) / res, (wy0 - m_mapInfo.origin.position.y) / res,
+                            (wx1 - m_mapInfo.origin.position.x) / res, (wy1 - m_mapInfo.origin.position.y) / res,
+                            clearance, clearance);
+  // everything pruned means every cell had enough clearance
+  return minClearance >= clearance;
+}
+
+bool GridMap2D::segmentInBox(double mx0, double my0, double mx1, double my1, double x0, double y0, double x1, double y1){
+  // Liang-Barsky clipping of the segment against the box
+  double t0 = 0.0, t1 = 1.0;
+  const double d[2] = {mx1 - mx0, my1 - my0};
+  const double p0[2] = {mx0, my0};
+  const double lo[2] = {x0, y0};
+  const double hi[2] = {x1, y1};
+  for (int k = 0; k < 2; ++k){
+    if (d[k] == 0.0){
+      if (p0[k] < lo[k] || p0[k] > hi[k])
+        return false;
+      continue;
+    }
+    double ta = (lo[k] - p0[k]) / d[k];
+    double tb = (hi[k] - p0[k]) / d[k];
+    if (ta > tb)
+      std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    if (t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+bool GridMap2D::segmentInCells(double mx0, double my0, double mx1, double my1, int level, int x, int y) const{
+  // cells at the border of a coarse level can reach past the map, only count the part in the map
+  const int size = 1 << level;
+  return segmentInBox(mx0, my0, mx1, my1, x*size, y*size,
+                      std::min((x+1)*size, m_clearancePyramid[0].rows), std::min((y+1)*size, m_clearancePyramid[0].cols));
+}
+
+float GridMap2D::searchSegment(double mx0, double my0, double mx1, double my1, float prune, float stop) const{
+  const int top = m_clearancePyramid.size() - 1;
+  const cv::Mat& topLevel = m_clearancePyramid[top];
+  const int topSize = 1 << top;
+
+  // cells left to visit as <level, x, y>, the closest cells are visited first
+  std::vector<cv::Vec3i> cells;
+  int x0 = std::max(0, (int) std::floor(std::min(mx0, mx1) / topSize));
+  int y0 = std::max(0, (int) std::floor(std::min(my0, my1) / topSize));
+  int x1 = std::min(topLevel.rows - 1, (int) std::floor(std::max(mx0, mx1) / topSize));
+  int y1 = std::min(topLevel.cols - 1, (int) std::floor(std::max(my0, my1) / topSize));
+  for (int x = x0; x <= x1; ++x){
+    for (int y = y0; y <= y1; ++y){
+      if (segmentInCells(mx0, my0, mx1, my1, top, x, y))
+        cells.push_back(cv::Vec3i(top, x, y));
+    }
+  }
+
+  if (cells.empty())
+    return -1.0f;
+
+  float result = std::numeric_limits<float>::max();
+  while (!cells.empty() && result >= stop){
+    cv::Vec3i c = cells.back();
+    cells.pop_back();
+
+    // coarse cells are lower bounds, skip them if they can't lower the result or are clear enough
+    float bound = m_clearancePyramid[c[0]].at<float>(c[1], c[2]);
+    if (bound >= result || bound >= prune)
+      continue;
+
+    if (c[0] == 0){
+      result = bound;
+      continue;
+    }
+
+    // refine into the children that the segment crosses, the lowest one ends up on top
+    const cv::Mat& below = m_clearancePyramid[c[0]-1];
+    std::vector<std::pair<float, cv::Vec3i> > children;
+    for (int x = 2*c[1]; x <= 2*c[1]+1 && x < below.rows; ++x){
+      for (int y = 2*c[2]; y <= 2*c[2]+1 && y < below.cols; ++y){
+        if (segmentInCells(mx0, my0, mx1, my1, c[0]-1, x, y))
+          children.push_back(std::make_pair(below.at<float>(x, y), cv::Vec3i(c[0]-1, x, y)));
+      }
+    }
+    std::sort(children.begin(), children.end(), compareChildren);
+    for (int i = children.size()-1; i >= 0; --i)
+      cells.push_back(children[i].second);
+  }
+
+  return result;
 }
 
 void GridMap2D::setMap(const nav_msgs::OccupancyGridConstPtr& grid_map, bool unknown_as_obstacle){
@@ -122,6 +275,7 @@ nav_msgs::OccupancyGrid GridMap2D::toOccupancyGridMsg() const{
 }
 
 void GridMap2D::setMap(const cv::Mat& binaryMap){
+  m_clearancePyramid.clear();
   m_binaryMap = binaryMap.clone();
   m_distMap = cv::Mat(m_binaryMap.size(), CV_32FC1);
 
@@ -134,6 +288,7 @@ void GridMap2D::setMap(const cv::Mat& binaryMap){
 }
 
 void GridMap2D::inflateMap(double inflationRadius){
+  m_clearancePyramid.clear();
   m_binaryMap = (m_distMap > inflationRadius );
   // recompute distance map with new binary map:
   cv::distanceTransform(m_binaryMap, m_distMap, CV_DIST_L2, CV_DIST_MASK_PRECISE);
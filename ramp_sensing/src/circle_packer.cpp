@@ -2,28 +2,43 @@
 
 
 
+CirclePacker::CirclePacker() {}
+
 CirclePacker::CirclePacker(nav_msgs::OccupancyGridConstPtr g)
 {
   //ROS_INFO("In CirclePacker::CirclePacker()");
-  grid_ = *g;
-  convertOGtoMat(g);
+  update(g);
 }
 
 CirclePacker::~CirclePacker() {}
 
+void CirclePacker::update(nav_msgs::OccupancyGridConstPtr g)
+{
+  convertOGtoMat(g);
+}
+
 void CirclePacker::convertOGtoMat(nav_msgs::OccupancyGridConstPtr g)
 {
   //ROS_INFO("In CirclePacker::convertOGtoMat");
 
-  
-  // Use the GridMap2D library to convert from nav_msgs::OccupancyGrid to cv::Mat
-  gridmap_2d::GridMap2D gmap(g, false);
+  // Same layout and threshold as GridMap2D::setMap (x is the row), written into the
+  // existing image so a packer that is kept between grids of one size doesn't allocate.
+  // create does nothing if src already has this size and type
+  src.create(g->info.width, g->info.height, CV_8UC1);
+
+  std::vector<signed char>::const_iterator it = g->data.begin();
+  for(int j=0;j<g->info.height;j++)
+  {
+    for(int i=0;i<g->info.width;i++)
+    {
+      src.at<uchar>(i, j) = *it > OCC_THRESHOLD ? gridmap_2d::GridMap2D::OCCUPIED : gridmap_2d::GridMap2D::FREE;
+      ++it;
+    }
+  }
 
   // Create a window
   //cv::namedWindow("testing", CV_WINDOW_AUTOSIZE);
 
-  src = gmap.binaryMap();
-
   // Show the image
   //cv::imshow("testing", src);
 
@@ -294,6 +309,169 @@ std::vector<Circle> CirclePacker::getCirclesFromPoly(Polygon poly)
 }
 
 
+/*
+ * Packs the same way as getCirclesFromPoly: the next circle is always centered on the 
+ * uncovered cell that is farthest from the polygon edges and the circles placed so far. 
+ * Instead of recomputing every cell's distance for each circle, the distance of a cell 
+ * to the edges comes from one distance transform and the distance to the circles is 
+ * kept in a field that each new circle only updates around itself
+ */
+std::vector<Circle> CirclePacker::getCirclesFromPolyDistances(const Polygon& poly)
+{
+  std::vector<Circle> result;
+  if(poly.edges.size() == 0)
+  {
+    return result;
+  }
+
+  // Bounding box of the vertices, same cells as getCirclesFromPoly
+  double MIN_WIDTH = poly.edges[0].start.x, MAX_WIDTH = MIN_WIDTH;
+  double MIN_LENGTH = poly.edges[0].start.y, MAX_LENGTH = MIN_LENGTH;
+  for(int i=0;i<poly.edges.size();i++)
+  {
+    const cv::Point* v[2] = { &poly.edges[i].start, &poly.edges[i].end };
+    for(int j=0;j<2;j++)
+    {
+      MIN_WIDTH   = v[j]->x < MIN_WIDTH   ? v[j]->x : MIN_WIDTH;
+      MAX_WIDTH   = v[j]->x > MAX_WIDTH   ? v[j]->x : MAX_WIDTH;
+      MIN_LENGTH  = v[j]->y < MIN_LENGTH  ? v[j]->y : MIN_LENGTH;
+      MAX_LENGTH  = v[j]->y > MAX_LENGTH  ? v[j]->y : MAX_LENGTH;
+    }
+  }
+
+  int width_count = MAX_WIDTH - MIN_WIDTH;
+  int length_count = MAX_LENGTH - MIN_LENGTH;
+
+  if(width_count <= 0 || length_count <= 0)
+  {
+    return result;
+  }
+
+  // Rasterize the polygon with a border of free cells so the edges of the box count as outside
+  cv::Mat mask = cv::Mat::zeros(length_count+2, width_count+2, CV_8UC1);
+  for(int i=0;i<width_count;i++)
+  {
+    for(int j=0;j<length_count;j++)
+    {
+      cv::Point p(MIN_WIDTH + i, MIN_LENGTH + j);
+      if(cellInPoly(poly, p))
+      {
+        mask.at<uchar>(j+1, i+1) = gridmap_2d::GridMap2D::OCCUPIED;
+      }
+    }
+  }
+
+  // Distance (in cells) to the closest cell outside of the polygon
+  cv::Mat dist;
+  cv::distanceTransform(mask, dist, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+
+  result = getCirclesFromDistances(dist);
+  for(int i=0;i<result.size();i++)
+  {
+    result[i].center.x += MIN_WIDTH - 1;
+    result[i].center.y += MIN_LENGTH - 1;
+  }
+
+  return result;
+} // End getCirclesFromPolyDistances
+
+
+/*
+ * Each cell's packing distance starts at its distance to the outside and only ever 
+ * decreases as circles are placed, so cells whose distance changed are re-pushed 
+ * instead of being removed from the heap. When a circle of radius r is placed, every 
+ * remaining cell has a distance <= r, so only the cells within 2r of its center can change
+ */
+std::vector<Circle> CirclePacker::getCirclesFromDistances(const cv::Mat& dist) const
+{
+  std::vector<Circle> result;
+
+  // Packing distance of each cell, negative once the cell is covered or outside
+  cv::Mat field(dist.size(), CV_32FC1);
+  std::priority_queue<Cell, std::vector<Cell>, CompareDist> pq;
+
+  for(int r=0;r<dist.rows;r++)
+  {
+    for(int c=0;c<dist.cols;c++)
+    {
+      // The transform is the distance between cell centers, the edge is half a cell closer
+      float d = dist.at<float>(r, c);
+      if(d > 0)
+      {
+        Cell cell;
+        cell.p.x  = c;
+        cell.p.y  = r;
+        cell.dist = d - 0.5;
+        field.at<float>(r, c) = cell.dist;
+        pq.push(cell);
+      }
+      else
+      {
+        field.at<float>(r, c) = -1;
+      }
+    }
+  }
+
+  while(!pq.empty())
+  {
+    Cell cell = pq.top();
+    pq.pop();
+
+    float d = field.at<float>(cell.p.y, cell.p.x);
+
+    // Covered by a circle already
+    if(d < 0)
+    {
+      continue;
+    }
+
+    // Moved closer to a circle since it was pushed
+    if(d < cell.dist)
+    {
+      cell.dist = d;
+      pq.push(cell);
+      continue;
+    }
+
+    Circle temp;
+    temp.center.x = cell.p.x;
+    temp.center.y = cell.p.y;
+    temp.radius   = d;
+    result.push_back(temp);
+
+    // Update the cells near the new circle
+    int w = ceil(2*d) + 1;
+    int r_min = cell.p.y - w < 0 ? 0 : cell.p.y - w;
+    int r_max = cell.p.y + w >= dist.rows ? dist.rows-1 : cell.p.y + w;
+    int c_min = cell.p.x - w < 0 ? 0 : cell.p.x - w;
+    int c_max = cell.p.x + w >= dist.cols ? dist.cols-1 : cell.p.x + w;
+    for(int r=r_min;r<=r_max;r++)
+    {
+      for(int c=c_min;c<=c_max;c++)
+      {
+        float& f = field.at<float>(r, c);
+        if(f < 0)
+        {
+          continue;
+        }
+
+        double to_cir = sqrt( pow(c - cell.p.x, 2) + pow(r - cell.p.y, 2) ) - d;
+        if(to_cir <= 0)
+        {
+          f = -1;
+        }
+        else if(to_cir < f)
+        {
+          f = to_cir;
+        }
+      } // end inner for
+    } // end outer for
+  } // end while
+
+  return result;
+} // End getCirclesFromDistances
+
+
 std::vector<Triangle> CirclePacker::triangulatePolygon(const Polygon& poly)
 {
   std::vector<Triangle> result;
@@ -391,7 +569,7 @@ std::vector<visualization_msgs::Marker> CirclePacker::getMarkers(const std::vect
 }
 
 
-std::vector<Circle> CirclePacker::getCirclesFromEdgeSets(const std::vector< std::vector<Edge> > edge_sets)
+std::vector<Circle> CirclePacker::getCirclesFromEdgeSets(const std::vector< std::vector<Edge> > edge_sets) const
 {
   std::vector<Circle> result;
 
@@ -461,6 +639,41 @@ std::vector<Circle> CirclePacker::getCirclesFromEdgeSets(const std::vector< std:
   return result;
 }
 
+std::vector<Edge> CirclePacker::getEdgesFromContour(const std::vector<cv::Point>& contour) const
+{
+  std::vector<Edge> result;
+  for(int j=0;j<contour.size();j++)
+  {
+    //ROS_INFO("contour[%i]: (%i, %i)", j, contour[j].x, contour[j].y);
+    Edge temp;
+    temp.start.x = contour[j].x;
+    temp.start.y = contour[j].y;
+
+    // Last edge goes back to the first point
+    temp.end.x = contour[ (j+1) % contour.size() ].x;
+    temp.end.y = contour[ (j+1) % contour.size() ].y;
+
+    result.push_back(temp);
+  }
+
+  return result;
+} // End getEdgesFromContour
+
+
+ContourToCircles::ContourToCircles(const CirclePacker& packer, const std::vector< std::vector<cv::Point> >& contours, 
+    std::vector< std::vector<Circle> >& result) : packer_(packer), contours_(contours), result_(result) {}
+
+
+void ContourToCircles::operator()(const cv::Range& range) const
+{
+  for(int i=range.start;i<range.end;i++)
+  {
+    std::vector< std::vector<Edge> > edge_sets(1, packer_.getEdgesFromContour(contours_[i]));
+    result_[i] = packer_.getCirclesFromEdgeSets(edge_sets);
+  }
+} // End operator()
+
+
 std::vector<Circle> CirclePacker::getCirclesFromEdges(const std::vector<Edge> edges, const cv::Point robot_cen)
 {
   std::vector<Circle> result;
@@ -529,9 +742,8 @@ std::vector<Circle> CirclePacker::go()
   // Get the contour points
   ros::Time t_start_contour = ros::Time::now();
 
-  std::vector< std::vector<cv::Point> > detected_contours;
-  std::vector<cv::Vec4i> hierarchy;
-  cv::findContours(detected_edges, detected_contours, hierarchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+  std::vector< std::vector<cv::Point> >& detected_contours = contours_;
+  cv::findContours(detected_edges, detected_contours, hierarchy_, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
   
   ros::Duration d_contour(ros::Time::now() - t_start_contour);
 
@@ -541,42 +753,27 @@ std::vector<Circle> CirclePacker::go()
    * Get every edge in 1 vector, and make a circle for each edge
    */
 
-  // Make Edges from detected contour points (endpoints of edges)
-  std::vector< std::vector<Edge> > edge_sets;
-  std::vector<Edge> edges;
-  for(int i=0;i<detected_contours.size();i++)
+  // Make Edges from detected contour points (endpoints of edges) and a circle for each contour
+  // Contours are split across threads, the circles are merged in contour order so the 
+  // result is the same for any number of threads
+  ros::Time t_start_cirs_from_sets = ros::Time::now();
+  std::vector< std::vector<Circle> >& contour_cirs = contour_cirs_;
+  contour_cirs.resize(detected_contours.size());
+  ContourToCircles body(*this, detected_contours, contour_cirs);
+  if(detected_contours.size() < PARALLEL_MIN_CONTOURS)
   {
-    std::vector<Edge> set;
-    //ROS_INFO("detected_contours[%i].size(): %i", i, (int)detected_contours[i].size());
-    for(int j=0;j<detected_contours[i].size()-1;j++)
-    {
-      //ROS_INFO("detected_contours[%i][%i]: (%i, %i)", i, j, detected_contours[i][j].x, detected_contours[i][j].y);
-      Edge temp;
-      temp.start.x = detected_contours[i][j].x;
-      temp.start.y = detected_contours[i][j].y;
-
-      temp.end.x = detected_contours[i][j+1].x;
-      temp.end.y = detected_contours[i][j+1].y;
-
-      edges.push_back(temp);
-      set.push_back(temp);
-    }
-    
-    Edge temp;
-    temp.start.x = detected_contours[i][detected_contours[i].size()-1].x;
-    temp.start.y = detected_contours[i][detected_contours[i].size()-1].y;
-
-    temp.end.x = detected_contours[i][0].x;
-    temp.end.y = detected_contours[i][0].y;
-
-    edges.push_back(temp);
-    set.push_back(temp);
-
-    edge_sets.push_back(set);
+    body(cv::Range(0, detected_contours.size()));
+  }
+  else
+  {
+    cv::parallel_for_(cv::Range(0, detected_contours.size()), body);
   }
-  //ROS_INFO("Edges.size(): %i", (int)edges.size());
-
 
+  for(int i=0;i<contour_cirs.size();i++)
+  {
+    result.insert(result.end(), contour_cirs[i].begin(), contour_cirs[i].end());
+  }
+  ros::Duration d_cirs_from_sets(ros::Time::now() - t_start_cirs_from_sets);
 
 
 
@@ -595,15 +792,6 @@ std::vector<Circle> CirclePacker::go()
     ROS_INFO("Circle %i - Center: (%i, %i) Radius: %f", i, cirs_from_edges[i].center.x, cirs_from_edges[i].center.y, cirs_from_edges[i].radius);
   }*/
 
-  ros::Time t_start_cirs_from_sets = ros::Time::now();
-  std::vector<Circle> cirs_from_sets = getCirclesFromEdgeSets(edge_sets);
-  ros::Duration d_cirs_from_sets(ros::Time::now() - t_start_cirs_from_sets);
-
-  for(int i=0;i<cirs_from_sets.size();i++)
-  {
-    //ROS_INFO("Circle %i - Center: (%f, %f) Radius: %f", i, cirs_from_sets[i].center.x, cirs_from_sets[i].center.y, cirs_from_sets[i].radius);
-    result.push_back(cirs_from_sets[i]);
-  }
 
 
   /*
@@ -5,17 +5,22 @@
 #include "nav_msgs/Odometry.h"
 #include "tf/transform_datatypes.h"
 #include "ramp_msgs/ObstacleList.h"
+#include "ramp_msgs/RampTrajectory.h"
 #include "obstacle.h"
 #include "nav_msgs/OccupancyGrid.h"
 #include "map_msgs/OccupancyGridUpdate.h"
 #include "circle_packer.h"
+#include "obstacle_tracker.h"
 #include <visualization_msgs/MarkerArray.h>
 
 
 double rate;
 ros::Publisher pub_obj, pub_rviz;
 std::vector< Obstacle> obs;
-ramp_msgs::ObstacleList list;
+
+// Version of the published obstacles, incremented whenever a list differs from the previous one
+uint32_t list_version = 0;
+std::vector<ramp_msgs::Obstacle> published_obs;
 std::vector< std::string > ob_odoms;
 std::map< std::string, uint8_t > topic_index_map;
 nav_msgs::OccupancyGrid global_grid;
@@ -24,6 +29,31 @@ std::vector<tf::Transform> ob_tfs;
 
 size_t prev_size;
 
+// Side length of a costmap tile, in cells
+#define TILE_SIZE 32
+
+// Circles are kept per tile so an update only repacks the tiles it touched
+int n_tiles_x, n_tiles_y;
+std::vector<bool> dirty_tiles;
+std::vector< std::vector<Circle> > tile_cirs;
+
+// Keeps obstacles and their velocities across costmaps
+ObstacleTracker tracker;
+
+// Packers and the region grid are kept between frames so their buffers are reused
+CirclePacker packer, region_packer;
+nav_msgs::OccupancyGridPtr region(new nav_msgs::OccupancyGrid);
+
+// Region of interest, the bounding box of the planner's best trajectory plus roi_margin (meters)
+// Frames only pack the tiles in it, except every full_refresh_frames frames
+#define ROI_TIMEOUT 1.0
+bool roi_valid = false;
+double roi_x_min, roi_y_min, roi_x_max, roi_y_max;
+ros::Time t_roi;
+double roi_margin;
+int full_refresh_frames;
+int frames_since_full = 0;
+
 
 void loadObstacleTF()
 {
@@ -84,24 +114,74 @@ void updateOtherRobotCb(const nav_msgs::Odometry::ConstPtr& o, const std::string
     //ROS_INFO("In if obs.size() < index");
     Obstacle temp(*o);
     obs.push_back(temp);
-    list.obstacles.push_back(temp.msg_);
   }
   else
   {
     //ROS_INFO("In else");
     obs.at(index).update(*o);
-    list.obstacles.at(index) = obs.at(index).msg_;
   }
 } //End updateOtherRobotCb
 
 
 
 
-/** Publish the list of objects */
+/** 
+ * True if the obstacles of a and b are the same, so the planner's predictions of a hold for b
+ * The time of the motion states is not compared, it changes every sensing cycle
+ */
+bool sameObstacles(const std::vector<ramp_msgs::Obstacle>& a, const std::vector<ramp_msgs::Obstacle>& b)
+{
+  if(a.size() != b.size())
+  {
+    return false;
+  }
+
+  for(int i=0;i<a.size();i++)
+  {
+    const geometry_msgs::Transform& t_a = a[i].T_w_odom;
+    const geometry_msgs::Transform& t_b = b[i].T_w_odom;
+    if(a[i].id != b[i].id || 
+        a[i].ob_ms.positions      != b[i].ob_ms.positions ||
+        a[i].ob_ms.velocities     != b[i].ob_ms.velocities ||
+        a[i].ob_ms.accelerations  != b[i].ob_ms.accelerations ||
+        t_a.translation.x != t_b.translation.x || t_a.translation.y != t_b.translation.y || 
+        t_a.translation.z != t_b.translation.z || t_a.rotation.x != t_b.rotation.x || 
+        t_a.rotation.y != t_b.rotation.y || t_a.rotation.z != t_b.rotation.z || 
+        t_a.rotation.w != t_b.rotation.w)
+    {
+      return false;
+    }
+  }
+
+  return true;
+} // End sameObstacles
+
+
+/** 
+ * Publish the list of objects
+ * The list is published through a shared pointer so subscribers in the same process 
+ * (e.g. the planner in a nodelet manager) get it without serialization. It must not 
+ * be modified after publishing, a new list is built every time
+ */
 void publishList(const ros::TimerEvent& e) 
 {
+  ramp_msgs::ObstacleListPtr list(new ramp_msgs::ObstacleList);
+  list->obstacles.reserve(obs.size());
+  for(int i=0;i<obs.size();i++)
+  {
+    list->obstacles.push_back(obs[i].msg_);
+  }
+
+  // Only a new version when the obstacles changed, the planner reuses its predictions otherwise
+  if(!sameObstacles(list->obstacles, published_obs))
+  {
+    list_version++;
+    published_obs = list->obstacles;
+  }
+  list->version = list_version;
+
   //pub_obj.publish(obstacle.buildObstacleMsg());
-  pub_obj.publish(list);
+  pub_obj.publish(ramp_msgs::ObstacleListConstPtr(list));
 } //End sendList
 
 
@@ -197,29 +277,321 @@ void publishMarkers(const ros::TimerEvent& e)
 
 
 
-void costmapCb(const nav_msgs::OccupancyGridConstPtr grid)
+/** Track the circles of every tile and rebuild the obstacles from the tracks that were seen */
+void updateObstacles()
 {
-  global_grid = *grid;
-  //ROS_INFO("Got a new costmap!");
-  CirclePacker c(grid);
-  std::vector<Circle> cirs = c.go();
+  std::vector<Circle> cirs;
+  for(int t=0;t<tile_cirs.size();t++)
+  {
+    cirs.insert(cirs.end(), tile_cirs[t].begin(), tile_cirs[t].end());
+  }
+
+  // Circles are in costmap cells, the tracker works in meters
+  std::vector<Point> centers(cirs.size());
+  for(int i=0;i<cirs.size();i++)
+  {
+    centers[i].x = global_grid.info.origin.position.x + cirs[i].center.x*global_grid.info.resolution;
+    centers[i].y = global_grid.info.origin.position.y + cirs[i].center.y*global_grid.info.resolution;
+  }
+
+  tracker.update(cirs, centers, ros::Time::now());
+
+  std::vector<Track> tracks;
+  tracker.getVisibleTracks(tracks);
 
   prev_size = obs.size();
 
   obs.clear();
 
-  for(int i=0;i<cirs.size();i++)
+  for(int i=0;i<tracks.size();i++)
   {
     Obstacle o; 
-    o.cir_ = cirs[i];
+    o.update(tracks[i].cir, tracker.getMotionState(tracks[i]), tracks[i].id);
     obs.push_back(o);
   }
  
   //ROS_INFO("obs.size(): %i", (int)obs.size());
+} // End updateObstacles
+
+
+/** Size the tiles to global_grid and remove all of their circles */
+void initTiles()
+{
+  n_tiles_x = (global_grid.info.width + TILE_SIZE - 1) / TILE_SIZE;
+  n_tiles_y = (global_grid.info.height + TILE_SIZE - 1) / TILE_SIZE;
+
+  dirty_tiles.assign(n_tiles_x*n_tiles_y, false);
+  tile_cirs.clear();
+  tile_cirs.resize(n_tiles_x*n_tiles_y);
+} // End initTiles
+
+
+/** Index of the tile that a circle center falls in, centers off the map go to the closest tile */
+int getTileIndex(const Circle& cir)
+{
+  int tx = cir.center.x / TILE_SIZE;
+  int ty = cir.center.y / TILE_SIZE;
+
+  tx = tx < 0 ? 0 : tx >= n_tiles_x ? n_tiles_x-1 : tx;
+  ty = ty < 0 ? 0 : ty >= n_tiles_y ? n_tiles_y-1 : ty;
+
+  return ty*n_tiles_x + tx;
+} // End getTileIndex
+
+
+/** Replace the circles of every tile in mask with the circles in cirs that fall in a tile in mask */
+void setTileCircles(const std::vector<Circle>& cirs, const std::vector<bool>& mask)
+{
+  for(int t=0;t<tile_cirs.size();t++)
+  {
+    if(mask[t])
+    {
+      tile_cirs[t].clear();
+    }
+  }
+
+  for(int i=0;i<cirs.size();i++)
+  {
+    int t = getTileIndex(cirs[i]);
+    if(mask[t])
+    {
+      tile_cirs[t].push_back(cirs[i]);
+    }
+  }
+} // End setTileCircles
+
+
+/*
+ * Repack the dirty tiles in the tile window [tx_lo, tx_hi] x [ty_lo, ty_hi] and merge the
+ * new circles with the circles of the other tiles. The region that is packed is the 
+ * bounding box of those tiles plus one tile on each side so obstacles crossing into a 
+ * dirty tile are seen whole. Only circles centered in a repacked tile are kept, the other
+ * tiles keep the circles they had. Dirty tiles outside the window stay dirty
+ */
+void packDirtyTiles(const int tx_lo, const int ty_lo, const int tx_hi, const int ty_hi)
+{
+  std::vector<bool> packing(dirty_tiles.size(), false);
+  int tx_min = n_tiles_x, ty_min = n_tiles_y, tx_max = -1, ty_max = -1;
+  for(int ty=ty_lo;ty<=ty_hi;ty++)
+  {
+    for(int tx=tx_lo;tx<=tx_hi;tx++)
+    {
+      if(dirty_tiles[ty*n_tiles_x + tx])
+      {
+        packing[ty*n_tiles_x + tx] = true;
+        tx_min = tx < tx_min ? tx : tx_min;
+        ty_min = ty < ty_min ? ty : ty_min;
+        tx_max = tx > tx_max ? tx : tx_max;
+        ty_max = ty > ty_max ? ty : ty_max;
+      }
+    }
+  }
+
+  // Nothing changed
+  if(tx_max < 0)
+  {
+    return;
+  }
+
+  // Cells to pack
+  int x_min = (tx_min > 0 ? tx_min-1 : 0) * TILE_SIZE;
+  int y_min = (ty_min > 0 ? ty_min-1 : 0) * TILE_SIZE;
+  int x_max = (tx_max+2) * TILE_SIZE;
+  int y_max = (ty_max+2) * TILE_SIZE;
+  x_max = x_max > global_grid.info.width  ? global_grid.info.width  : x_max;
+  y_max = y_max > global_grid.info.height ? global_grid.info.height : y_max;
+
+  // Copy the region into its own grid
+  region->header            = global_grid.header;
+  region->info              = global_grid.info;
+  region->info.width        = x_max - x_min;
+  region->info.height       = y_max - y_min;
+  region->info.origin.position.x += x_min * global_grid.info.resolution;
+  region->info.origin.position.y += y_min * global_grid.info.resolution;
+  region->data.resize(region->info.width * region->info.height);
+  for(int y=y_min;y<y_max;y++)
+  {
+    std::copy(global_grid.data.begin() + y*global_grid.info.width + x_min, 
+              global_grid.data.begin() + y*global_grid.info.width + x_max,
+              region->data.begin() + (y-y_min)*region->info.width);
+  }
+
+  region_packer.update(region);
+  std::vector<Circle> cirs = region_packer.go();
+
+  // Move the circles back to global_grid cells
+  for(int i=0;i<cirs.size();i++)
+  {
+    cirs[i].center.x += x_min;
+    cirs[i].center.y += y_min;
+  }
+
+  setTileCircles(cirs, packing);
+  for(int t=0;t<dirty_tiles.size();t++)
+  {
+    dirty_tiles[t] = dirty_tiles[t] && !packing[t];
+  }
+} // End packDirtyTiles
+
+
+/** Get the window of tiles covering the region of interest, returns false if it misses the costmap */
+bool getRoiTiles(int& tx_lo, int& ty_lo, int& tx_hi, int& ty_hi)
+{
+  double res = global_grid.info.resolution;
+  int x_lo = (roi_x_min - global_grid.info.origin.position.x) / res;
+  int y_lo = (roi_y_min - global_grid.info.origin.position.y) / res;
+  int x_hi = (roi_x_max - global_grid.info.origin.position.x) / res;
+  int y_hi = (roi_y_max - global_grid.info.origin.position.y) / res;
+
+  if(x_hi < 0 || y_hi < 0 || x_lo >= (int)global_grid.info.width || y_lo >= (int)global_grid.info.height)
+  {
+    return false;
+  }
+
+  tx_lo = x_lo < 0 ? 0 : x_lo / TILE_SIZE;
+  ty_lo = y_lo < 0 ? 0 : y_lo / TILE_SIZE;
+  tx_hi = x_hi / TILE_SIZE >= n_tiles_x ? n_tiles_x-1 : x_hi / TILE_SIZE;
+  ty_hi = y_hi / TILE_SIZE >= n_tiles_y ? n_tiles_y-1 : y_hi / TILE_SIZE;
+  return true;
+} // End getRoiTiles
+
+
+/** 
+ * Pack the dirty tiles that this frame needs. Every full_refresh_frames frames, or when 
+ * there is no recent region of interest, all of them are packed
+ */
+void packFrame()
+{
+  int tx_lo=0, ty_lo=0, tx_hi=n_tiles_x-1, ty_hi=n_tiles_y-1;
+
+  frames_since_full++;
+  bool roi_fresh = roi_valid && (ros::Time::now() - t_roi).toSec() < ROI_TIMEOUT;
+  if(!roi_fresh || frames_since_full >= full_refresh_frames)
+  {
+    frames_since_full = 0;
+  }
+  // Region of interest is off the costmap, nothing to pack
+  else if(!getRoiTiles(tx_lo, ty_lo, tx_hi, ty_hi))
+  {
+    return;
+  }
+
+  packDirtyTiles(tx_lo, ty_lo, tx_hi, ty_hi);
+} // End packFrame
+
+
+/** Set the region of interest from the planner's best trajectory */
+void bestTrajecCb(const ramp_msgs::RampTrajectoryConstPtr trj)
+{
+  const std::vector<trajectory_msgs::JointTrajectoryPoint>& points = trj->trajectory.points;
+  if(points.size() == 0)
+  {
+    roi_valid = false;
+    return;
+  }
+
+  roi_x_min = roi_x_max = points[0].positions.at(0);
+  roi_y_min = roi_y_max = points[0].positions.at(1);
+  for(int i=1;i<points.size();i++)
+  {
+    roi_x_min = points[i].positions.at(0) < roi_x_min ? points[i].positions.at(0) : roi_x_min;
+    roi_y_min = points[i].positions.at(1) < roi_y_min ? points[i].positions.at(1) : roi_y_min;
+    roi_x_max = points[i].positions.at(0) > roi_x_max ? points[i].positions.at(0) : roi_x_max;
+    roi_y_max = points[i].positions.at(1) > roi_y_max ? points[i].positions.at(1) : roi_y_max;
+  }
+
+  roi_x_min -= roi_margin;
+  roi_y_min -= roi_margin;
+  roi_x_max += roi_margin;
+  roi_y_max += roi_margin;
+
+  roi_valid = true;
+  t_roi     = ros::Time::now();
+} // End bestTrajecCb
+
+
+void costmapCb(const nav_msgs::OccupancyGridConstPtr grid)
+{
+  //ROS_INFO("Got a new costmap!");
+
+  // If the costmap has the same cells, only mark the tiles that changed and pack the ones this frame needs
+  if(global_grid.data.size() == grid->data.size() && 
+      global_grid.info.width == grid->info.width &&
+      global_grid.info.origin.position.x == grid->info.origin.position.x &&
+      global_grid.info.origin.position.y == grid->info.origin.position.y)
+  {
+    for(int i=0;i<grid->data.size();i++)
+    {
+      if(global_grid.data[i] != grid->data[i])
+      {
+        int x = i % grid->info.width;
+        int y = i / grid->info.width;
+        dirty_tiles[ (y/TILE_SIZE)*n_tiles_x + x/TILE_SIZE ] = true;
+      }
+    }
+    global_grid = *grid;
+
+    packFrame();
+    updateObstacles();
+    return;
+  }
+
+  global_grid = *grid;
+  packer.update(grid);
+  std::vector<Circle> cirs = packer.go();
+
+  // Every tile is replaced on a new costmap
+  initTiles();
+  setTileCircles(cirs, std::vector<bool>(tile_cirs.size(), true));
+  frames_since_full = 0;
+
+  updateObstacles();
+ 
   //ROS_INFO("Leaving Cb");
 }
 
 
+/** Apply a costmap delta to global_grid and only repack the tiles it changed */
+void costmapUpdateCb(const map_msgs::OccupancyGridUpdateConstPtr update)
+{
+  //ROS_INFO("Got a costmap update!");
+
+  // Updates can only be applied on top of a full costmap
+  if(global_grid.data.size() == 0 || 
+      update->x < 0 || update->y < 0 ||
+      update->x + update->width  > global_grid.info.width ||
+      update->y + update->height > global_grid.info.height ||
+      update->data.size() < update->width * update->height)
+  {
+    ROS_WARN("ramp_sensing: Ignoring costmap update that does not fit the costmap");
+    return;
+  }
+
+  ros::Time t_start = ros::Time::now();
+
+  // Copy the changed cells and find the tiles that changed
+  for(int y=0;y<update->height;y++)
+  {
+    int i_row = (update->y + y)*global_grid.info.width + update->x;
+    for(int x=0;x<update->width;x++)
+    {
+      int8_t value = update->data[y*update->width + x];
+      if(global_grid.data[i_row + x] != value)
+      {
+        global_grid.data[i_row + x] = value;
+        dirty_tiles[ ((update->y + y)/TILE_SIZE)*n_tiles_x + (update->x + x)/TILE_SIZE ] = true;
+      }
+    }
+  }
+
+  packFrame();
+  updateObstacles();
+
+  ros::Duration d_update(ros::Time::now() - t_start);
+  ROS_DEBUG("d_update: %f", d_update.toSec());
+} // End costmapUpdateCb
+
+
 int main(int argc, char** argv) 
 {
   ros::init(argc, argv, "ramp_sensing");
@@ -248,16 +620,6 @@ int main(int argc, char** argv)
     ROS_ERROR("ramp_sensing: Could not find obstacle_topics rosparam!");
   }
 
-  if(handle.hasParam("/ramp/sensing_cycle_rate"))
-  {
-    handle.getParam("/ramp/sensing_cycle_rate", rate);
-    ROS_INFO("Sensing cycle rate: %f", rate);
-  }
-  else
-  {
-    ROS_ERROR("ramp_sensing: Could not find sensing_cycle_rate rosparam!");
-  }
-
   loadObstacleTF();
 
   // Create subscribers
@@ -267,20 +629,41 @@ int main(int argc, char** argv)
     Obstacle temp;
     temp.T_w_init_ = ob_tfs[i];
     obs.push_back(temp);
-    list.obstacles.push_back(temp.msg_);
 
     ros::Subscriber sub_ob = handle.subscribe<nav_msgs::Odometry>(ob_odoms.at(i), 1, boost::bind(updateOtherRobotCb, _1, ob_odoms.at(i)));
     subs_obs.push_back(sub_ob);
   } // end for*/
 
+  if(handle.hasParam("/ramp/sensing_cycle_rate"))
+  {
+    handle.getParam("/ramp/sensing_cycle_rate", rate);
+    ROS_INFO("Sensing cycle rate: %f", rate);
+  }
+  else
+  {
+    rate = 15;
+    ROS_ERROR("ramp_sensing: Could not find sensing_cycle_rate rosparam, using %f", rate);
+  }
+
+  handle.param("/ramp/sensing_roi_margin", roi_margin, 1.0);
+  handle.param("/ramp/sensing_full_refresh_frames", full_refresh_frames, 10);
+  ROS_INFO("Sensing ROI margin: %f full refresh frames: %i", roi_margin, full_refresh_frames);
+
   ros::Subscriber sub_costmap = handle.subscribe<nav_msgs::OccupancyGrid>("/costmap_node/costmap/costmap", 1, &costmapCb);
 
+  // Deltas are applied on top of the last full costmap, so don't drop them
+  ros::Subscriber sub_costmap_updates = handle.subscribe<map_msgs::OccupancyGridUpdate>("/costmap_node/costmap/costmap_updates", 10, &costmapUpdateCb);
+
+  // The planner's best trajectory sets the region of interest
+  ros::Subscriber sub_best_trajec = handle.subscribe<ramp_msgs::RampTrajectory>("bestTrajec", 1, &bestTrajecCb);
+
   //Publishers
   pub_obj = handle.advertise<ramp_msgs::ObstacleList>("obstacles", 1);
   pub_rviz = handle.advertise<visualization_msgs::MarkerArray>("visualization_marker_array", 1);
 
   //Timers
-  //ros::Timer timer = handle.createTimer(ros::Duration(1.f / rate), publishList);
+  // The list goes out at a fixed rate no matter how often the costmap changes
+  ros::Timer timer = handle.createTimer(ros::Duration(1.f / rate), publishList);
   ros::Timer timer_markers = handle.createTimer(ros::Duration(1.f/10.f), publishMarkers);
    
 
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <algorithm>
+#include "ros/ros.h"
+#include "circle_packer.h"
+
+
+/*
+ * Compares CirclePacker::getCirclesFromPoly with CirclePacker::getCirclesFromPolyDistances
+ * on random convex polygons of increasing size. Prints the time spent and the circles
+ * each one places, and fails if the circles of getCirclesFromPolyDistances leave the
+ * polygon or cover less of it than the circles of getCirclesFromPoly
+ */
+
+// Cells a circle may reach past the polygon, the distance transform is measured between cell centers
+#define MAX_OUTSIDE 1.5
+
+// Fraction of the polygon's cells getCirclesFromPolyDistances may cover less than getCirclesFromPoly
+#define MAX_COVERAGE_LOSS 0.05
+
+
+/** Build a polygon from the vertices in counter-clockwise order (in grid coordinates) */
+Polygon buildPolygon(const std::vector<cv::Point>& vertices, CirclePacker& c)
+{
+  Polygon result;
+  for(int i=0;i<vertices.size();i++)
+  {
+    Edge temp;
+    temp.start  = vertices[i];
+    temp.end    = vertices[ (i+1) % vertices.size() ];
+    result.edges.push_back(temp);
+    result.normals.push_back(c.computeNormal(temp));
+  }
+
+  return result;
+}
+
+
+/** Random convex polygon that fits in a size x size box */
+Polygon getRandomPolygon(const int size, CirclePacker& c)
+{
+  // Points on an ellipse are always convex
+  int n = 3 + rand() % 6;
+  double a = (size/2) * (0.5 + (rand() % 50) / 100.);
+  double b = (size/2) * (0.5 + (rand() % 50) / 100.);
+  std::vector<cv::Point> vertices;
+  for(int i=0;i<n;i++)
+  {
+    double theta = (2*PI*i) / n;
+    vertices.push_back(cv::Point(size/2 + a*cos(theta), size/2 + b*sin(theta)));
+  }
+
+  return buildPolygon(vertices, c);
+}
+
+
+double getArea(const std::vector<Circle>& cirs)
+{
+  double result = 0;
+  for(int i=0;i<cirs.size();i++)
+  {
+    result += PI*cirs[i].radius*cirs[i].radius;
+  }
+  return result;
+}
+
+
+/** Fraction of the cells in poly (the cells getCirclesFromPoly packs) inside one of cirs */
+double getCoverage(const Polygon& poly, const std::vector<Circle>& cirs, CirclePacker& c)
+{
+  int min_x = poly.edges[0].start.x, max_x = min_x;
+  int min_y = poly.edges[0].start.y, max_y = min_y;
+  for(int i=0;i<poly.edges.size();i++)
+  {
+    min_x = std::min(min_x, std::min(poly.edges[i].start.x, poly.edges[i].end.x));
+    max_x = std::max(max_x, std::max(poly.edges[i].start.x, poly.edges[i].end.x));
+    min_y = std::min(min_y, std::min(poly.edges[i].start.y, poly.edges[i].end.y));
+    max_y = std::max(max_y, std::max(poly.edges[i].start.y, poly.edges[i].end.y));
+  }
+
+  int num_cells=0, num_covered=0;
+  for(int x=min_x;x<max_x;x++)
+  {
+    for(int y=min_y;y<max_y;y++)
+    {
+      if(!c.cellInPoly(poly, cv::Point(x, y)))
+      {
+        continue;
+      }
+
+      num_cells++;
+      for(int i=0;i<cirs.size();i++)
+      {
+        if(pow(cirs[i].center.x - x, 2) + pow(cirs[i].center.y - y, 2) <= cirs[i].radius*cirs[i].radius)
+        {
+          num_covered++;
+          break;
+        }
+      }
+    }
+  }
+
+  return num_cells > 0 ? (double)num_covered / num_cells : 1;
+}
+
+
+/** True if every circle is centered in poly and reaches at most MAX_OUTSIDE cells past its edges */
+bool insidePoly(const Polygon& poly, const std::vector<Circle>& cirs, CirclePacker& c)
+{
+  for(int i=0;i<cirs.size();i++)
+  {
+    Cell cell;
+    cell.p = cv::Point(cirs[i].center.x, cirs[i].center.y);
+    if(!c.cellInPoly(poly, cell.p) || cirs[i].radius > c.getMinDistToPoly(poly, cell) + MAX_OUTSIDE)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "benchmark_packing");
+  srand(0);
+
+  // The packer needs a grid, the polygons don't use it
+  nav_msgs::OccupancyGridPtr grid(new nav_msgs::OccupancyGrid);
+  grid->info.width      = 1;
+  grid->info.height     = 1;
+  grid->info.resolution = 0.05;
+  grid->data.push_back(0);
+  CirclePacker c(grid);
+
+  int num_failed = 0;
+  int num_polys = 10;
+  int sizes[] = {10, 20, 40, 80};
+  for(int s=0;s<4;s++)
+  {
+    ros::WallDuration d_poly, d_dist;
+    int n_poly=0, n_dist=0;
+    double area_poly=0, area_dist=0;
+    for(int i=0;i<num_polys;i++)
+    {
+      Polygon p = getRandomPolygon(sizes[s], c);
+
+      ros::WallTime t_start = ros::WallTime::now();
+      std::vector<Circle> cirs_poly = c.getCirclesFromPoly(p);
+      d_poly += ros::WallTime::now() - t_start;
+
+      t_start = ros::WallTime::now();
+      std::vector<Circle> cirs_dist = c.getCirclesFromPolyDistances(p);
+      d_dist += ros::WallTime::now() - t_start;
+
+      double coverage_poly = getCoverage(p, cirs_poly, c);
+      double coverage_dist = getCoverage(p, cirs_dist, c);
+      if(!insidePoly(p, cirs_dist, c) || coverage_dist < coverage_poly - MAX_COVERAGE_LOSS)
+      {
+        std::cout<<"\nFAILED size "<<sizes[s]<<" polygon "<<i<<": coverage "<<coverage_dist
+          <<" (getCirclesFromPoly: "<<coverage_poly<<")";
+        num_failed++;
+      }
+
+      n_poly += cirs_poly.size();
+      n_dist += cirs_dist.size();
+      area_poly += getArea(cirs_poly);
+      area_dist += getArea(cirs_dist);
+    }
+
+    std::cout<<"\nPolygon size: "<<sizes[s];
+    std::cout<<"\n  getCirclesFromPoly:          "<<d_poly.toSec() / num_polys<<" s, "
+      <<n_poly / num_polys<<" circles, area: "<<area_poly / num_polys;
+    std::cout<<"\n  getCirclesFromPolyDistances: "<<d_dist.toSec() / num_polys<<" s, "
+      <<n_dist / num_polys<<" circles, area: "<<area_dist / num_polys;
+  }
+
+  if(num_failed > 0)
+  {
+    std::cout<<"\n\n"<<num_failed<<" polygons packed differently\n";
+    return 1;
+  }
+
+  std::cout<<"\n\nExiting Normally\n";
+  return 0;
+}
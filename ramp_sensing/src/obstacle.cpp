@@ -40,6 +40,23 @@ void Obstacle::update(const Circle c)
   last_updated_ = ros::Time::now();
 }
 
+/** ms is in the world frame, odom_t is filled from it so it matches msg_ */
+void Obstacle::update(const Circle c, const ramp_msgs::MotionState& ms, const uint32_t id)
+{
+  cir_ = c;
+
+  odom_t.pose.pose.position.x     = ms.positions.at(0);
+  odom_t.pose.pose.position.y     = ms.positions.at(1);
+  odom_t.pose.pose.orientation    = tf::createQuaternionMsgFromYaw(ms.positions.at(2));
+  odom_t.twist.twist.linear.x     = sqrt( pow(ms.velocities.at(0),2) + pow(ms.velocities.at(1),2) );
+  odom_t.twist.twist.angular.z    = ms.velocities.at(2);
+
+  msg_.ob_ms  = ms;
+  msg_.id     = id;
+
+  last_updated_ = ros::Time::now();
+}
+
 void Obstacle::doTF()
 {
   ramp_msgs::MotionState ms;
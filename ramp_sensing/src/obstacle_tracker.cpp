@@ -0,0 +1,206 @@
+#include "obstacle_tracker.h"
+#include <algorithm>
+
+
+struct Association
+{
+  int i_track;
+  int i_cir;
+  double dist;
+};
+
+struct CompareAssociation
+{
+  bool operator()(const Association& a, const Association& b) const
+  {
+    return a.dist < b.dist;
+  }
+};
+
+
+ObstacleTracker::ObstacleTracker() : gate_(0.5), sigma_a_(0.5), sigma_z_(0.1), max_misses_(3), next_id_(0) {}
+
+ObstacleTracker::~ObstacleTracker() {}
+
+
+const std::vector<Track>& ObstacleTracker::tracks() const
+{
+  return tracks_;
+}
+
+
+void ObstacleTracker::initFilter(const double z, AxisFilter& f) const
+{
+  f.p = z;
+  f.v = 0;
+
+  // Position is as good as the measurement, velocity is unknown
+  f.P[0][0] = sigma_z_*sigma_z_;
+  f.P[0][1] = 0;
+  f.P[1][0] = 0;
+  f.P[1][1] = 1;
+} // End initFilter
+
+
+void ObstacleTracker::predict(const double dt, AxisFilter& f) const
+{
+  f.p += f.v*dt;
+
+  // P = F*P*F^T + Q
+  double p00 = f.P[0][0] + dt*(f.P[1][0] + f.P[0][1]) + dt*dt*f.P[1][1];
+  double p01 = f.P[0][1] + dt*f.P[1][1];
+  double p10 = f.P[1][0] + dt*f.P[1][1];
+  double p11 = f.P[1][1];
+
+  double q = sigma_a_*sigma_a_;
+  f.P[0][0] = p00 + q*dt*dt*dt*dt/4.;
+  f.P[0][1] = p01 + q*dt*dt*dt/2.;
+  f.P[1][0] = p10 + q*dt*dt*dt/2.;
+  f.P[1][1] = p11 + q*dt*dt;
+} // End predict
+
+
+void ObstacleTracker::correct(const double z, AxisFilter& f) const
+{
+  double s  = f.P[0][0] + sigma_z_*sigma_z_;
+  double k0 = f.P[0][0] / s;
+  double k1 = f.P[1][0] / s;
+  double y  = z - f.p;
+
+  f.p += k0*y;
+  f.v += k1*y;
+
+  // P = (I - K*H)*P
+  double p00 = (1-k0)*f.P[0][0];
+  double p01 = (1-k0)*f.P[0][1];
+  double p10 = f.P[1][0] - k1*f.P[0][0];
+  double p11 = f.P[1][1] - k1*f.P[0][1];
+  f.P[0][0] = p00;
+  f.P[0][1] = p01;
+  f.P[1][0] = p10;
+  f.P[1][1] = p11;
+} // End correct
+
+
+/*
+ * Associates circles to tracks closest pair first, comparing each circle to where the
+ * track is predicted to be at t, while the pair is within gate_. Tracks without a circle
+ * are dropped after max_misses_ updates and circles without a track start new ones
+ */
+void ObstacleTracker::update(const std::vector<Circle>& cirs, const std::vector<Point>& centers, const ros::Time& t)
+{
+  // Find every pair within the gate
+  std::vector<Association> pairs;
+  for(int i=0;i<tracks_.size();i++)
+  {
+    double dt = (t - tracks_[i].last_seen).toSec();
+    double x  = tracks_[i].x.p + tracks_[i].x.v*dt;
+    double y  = tracks_[i].y.p + tracks_[i].y.v*dt;
+
+    for(int j=0;j<centers.size();j++)
+    {
+      double d = sqrt( pow(x - centers[j].x, 2) + pow(y - centers[j].y, 2) );
+      if(d < gate_)
+      {
+        Association a;
+        a.i_track = i;
+        a.i_cir   = j;
+        a.dist    = d;
+        pairs.push_back(a);
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(), CompareAssociation());
+
+  // Greedily take the closest pairs
+  std::vector<bool> track_used(tracks_.size(), false);
+  std::vector<bool> cir_used(centers.size(), false);
+  for(int i=0;i<pairs.size();i++)
+  {
+    const Association& a = pairs[i];
+    if(track_used[a.i_track] || cir_used[a.i_cir])
+    {
+      continue;
+    }
+    track_used[a.i_track] = true;
+    cir_used[a.i_cir]     = true;
+
+    Track& track = tracks_[a.i_track];
+    double dt = (t - track.last_seen).toSec();
+    if(dt > 0)
+    {
+      predict(dt, track.x);
+      predict(dt, track.y);
+    }
+    correct(centers[a.i_cir].x, track.x);
+    correct(centers[a.i_cir].y, track.y);
+    track.cir       = cirs[a.i_cir];
+    track.last_seen = t;
+    track.hits++;
+    track.misses    = 0;
+  }
+
+  // Tracks that were not seen keep their state until they are seen again or dropped
+  std::vector<Track> kept;
+  kept.reserve(tracks_.size() + centers.size());
+  for(int i=0;i<tracks_.size();i++)
+  {
+    if(!track_used[i])
+    {
+      tracks_[i].misses++;
+    }
+
+    if(tracks_[i].misses <= max_misses_)
+    {
+      kept.push_back(tracks_[i]);
+    }
+  }
+
+  // New tracks
+  for(int j=0;j<centers.size();j++)
+  {
+    if(!cir_used[j])
+    {
+      Track track;
+      track.id        = next_id_++;
+      initFilter(centers[j].x, track.x);
+      initFilter(centers[j].y, track.y);
+      track.cir       = cirs[j];
+      track.last_seen = t;
+      track.hits      = 1;
+      track.misses    = 0;
+      kept.push_back(track);
+    }
+  }
+
+  tracks_.swap(kept);
+} // End update
+
+
+void ObstacleTracker::getVisibleTracks(std::vector<Track>& result) const
+{
+  result.clear();
+  for(int i=0;i<tracks_.size();i++)
+  {
+    if(tracks_[i].misses == 0)
+    {
+      result.push_back(tracks_[i]);
+    }
+  }
+} // End getVisibleTracks
+
+
+const ramp_msgs::MotionState ObstacleTracker::getMotionState(const Track& track) const
+{
+  ramp_msgs::MotionState result;
+
+  result.positions.push_back(track.x.p);
+  result.positions.push_back(track.y.p);
+  result.positions.push_back(atan2(track.y.v, track.x.v));
+
+  result.velocities.push_back(track.x.v);
+  result.velocities.push_back(track.y.v);
+  result.velocities.push_back(0);
+
+  return result;
+} // End getMotionState
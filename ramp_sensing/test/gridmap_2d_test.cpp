@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include "../include/GridMap2D.h"
+
+using gridmap_2d::GridMap2D;
+
+
+/** Random map of w x h cells, at least one of them occupied */
+nav_msgs::OccupancyGridPtr getRandomGrid(const unsigned int w, const unsigned int h, const int percent_occupied)
+{
+  nav_msgs::OccupancyGridPtr result(new nav_msgs::OccupancyGrid);
+  result->info.width      = w;
+  result->info.height     = h;
+  result->info.resolution = 0.05;
+  result->info.origin.position.x = -1.;
+  result->info.origin.position.y = 2.;
+
+  for(unsigned int i=0;i<w*h;i++)
+  {
+    result->data.push_back(rand() % 100 < percent_occupied ? 100 : 0);
+  }
+  result->data[rand() % (w*h)] = 100;
+
+  return result;
+}
+
+
+double getRandom(const double lo, const double hi)
+{
+  return lo + (hi - lo) * (rand() / (double)RAND_MAX);
+}
+
+
+/** Orientation of c relative to a->b, 0 if collinear */
+int orientation(const double ax, const double ay, const double bx, const double by, const double cx, const double cy)
+{
+  double cross = (bx - ax)*(cy - ay) - (by - ay)*(cx - ax);
+  return cross > 0 ? 1 : cross < 0 ? -1 : 0;
+}
+
+
+bool onSegment(const double ax, const double ay, const double bx, const double by, const double cx, const double cy)
+{
+  return std::min(ax, bx) <= cx && cx <= std::max(ax, bx) && std::min(ay, by) <= cy && cy <= std::max(ay, by);
+}
+
+
+/** Segment-segment intersection, touching counts */
+bool segmentsIntersect(const double ax, const double ay, const double bx, const double by,
+    const double cx, const double cy, const double dx, const double dy)
+{
+  int o1 = orientation(ax, ay, bx, by, cx, cy);
+  int o2 = orientation(ax, ay, bx, by, dx, dy);
+  int o3 = orientation(cx, cy, dx, dy, ax, ay);
+  int o4 = orientation(cx, cy, dx, dy, bx, by);
+
+  if(o1 != o2 && o3 != o4)
+  {
+    return true;
+  }
+
+  return (o1 == 0 && onSegment(ax, ay, bx, by, cx, cy)) || (o2 == 0 && onSegment(ax, ay, bx, by, dx, dy)) ||
+         (o3 == 0 && onSegment(cx, cy, dx, dy, ax, ay)) || (o4 == 0 && onSegment(cx, cy, dx, dy, bx, by));
+}
+
+
+/** Min clearance of every level 0 cell the segment (in map cells) touches, -1 if it touches none */
+float bruteSegment(const GridMap2D& map, const double mx0, const double my0, const double mx1, const double my1)
+{
+  const cv::Mat& level = map.clearancePyramid()[0];
+  float result = -1;
+  for(int x=0;x<level.rows;x++)
+  {
+    for(int y=0;y<level.cols;y++)
+    {
+      bool inside = (x <= mx0 && mx0 <= x+1 && y <= my0 && my0 <= y+1) ||
+                    (x <= mx1 && mx1 <= x+1 && y <= my1 && my1 <= y+1);
+      bool crosses = segmentsIntersect(mx0, my0, mx1, my1, x, y, x+1, y) ||
+                     segmentsIntersect(mx0, my0, mx1, my1, x+1, y, x+1, y+1) ||
+                     segmentsIntersect(mx0, my0, mx1, my1, x+1, y+1, x, y+1) ||
+                     segmentsIntersect(mx0, my0, mx1, my1, x, y+1, x, y);
+      if((inside || crosses) && (result < 0 || level.at<float>(x, y) < result))
+      {
+        result = level.at<float>(x, y);
+      }
+    }
+  }
+
+  return result;
+}
+
+
+/** Min clearance of the cells hit by points sampled along the segment, -1 if none is in the map */
+float sampleSegment(const GridMap2D& map, const double mx0, const double my0, const double mx1, const double my1)
+{
+  const cv::Mat& level = map.clearancePyramid()[0];
+  float result = -1;
+  for(int i=0;i<=1000;i++)
+  {
+    double mx = mx0 + (mx1 - mx0)*i/1000.;
+    double my = my0 + (my1 - my0)*i/1000.;
+    if(mx >= 0 && my >= 0 && mx < level.rows && my < level.cols)
+    {
+      float c = level.at<float>((int)mx, (int)my);
+      result = (result < 0 || c < result) ? c : result;
+    }
+  }
+
+  return result;
+}
+
+
+/** Check both segment queries of map against the brute force on random segments, some of them leaving the map */
+void checkSegments(const GridMap2D& map, const int num_segments)
+{
+  const nav_msgs::MapMetaData& info = map.getInfo();
+  for(int i=0;i<num_segments;i++)
+  {
+    double mx0 = getRandom(-3, info.width+3);
+    double my0 = getRandom(-3, info.height+3);
+    double mx1 = getRandom(-3, info.width+3);
+    double my1 = getRandom(-3, info.height+3);
+
+    // Some horizontal and vertical segments
+    if(i % 10 == 1)
+    {
+      my1 = my0;
+    }
+    else if(i % 10 == 2)
+    {
+      mx1 = mx0;
+    }
+
+    double wx0 = info.origin.position.x + mx0*info.resolution;
+    double wy0 = info.origin.position.y + my0*info.resolution;
+    double wx1 = info.origin.position.x + mx1*info.resolution;
+    double wy1 = info.origin.position.y + my1*info.resolution;
+
+    float brute = bruteSegment(map, mx0, my0, mx1, my1);
+    float result = map.minClearanceAlongSegment(wx0, wy0, wx1, wy1);
+    EXPECT_FLOAT_EQ(brute, result)<<"Segment ("<<mx0<<", "<<my0<<") - ("<<mx1<<", "<<my1<<")";
+
+    // Sampling can only miss cells
+    float sampled = sampleSegment(map, mx0, my0, mx1, my1);
+    if(sampled >= 0)
+    {
+      EXPECT_LE(result, sampled);
+    }
+
+    double clearance = getRandom(0.01, 4*info.resolution);
+    EXPECT_EQ(brute >= clearance, map.isSegmentClear(wx0, wy0, wx1, wy1, clearance))
+      <<"Segment ("<<mx0<<", "<<my0<<") - ("<<mx1<<", "<<my1<<") clearance "<<clearance;
+  }
+}
+
+
+TEST(gridMap2DTest, testNoPyramid){
+    GridMap2D map(getRandomGrid(8, 8, 10));
+
+    EXPECT_FLOAT_EQ(-1, map.minClearanceAlongSegment(-0.9, 2.1, -0.7, 2.3));
+    EXPECT_FLOAT_EQ(-1, map.minClearanceInDisk(-0.9, 2.1, 0.1));
+    EXPECT_FALSE(map.isSegmentClear(-0.9, 2.1, -0.7, 2.3, 0.01));
+}
+
+
+TEST(gridMap2DTest, testSegmentMatchesBruteForce){
+    srand(1);
+    GridMap2D map(getRandomGrid(32, 32, 5));
+    map.updateClearancePyramid(4);
+    checkSegments(map, 500);
+}
+
+
+TEST(gridMap2DTest, testSegmentOddSizes){
+    srand(2);
+    unsigned int sizes[][2] = { {13, 7}, {1, 9}, {17, 1}, {5, 5}, {31, 19} };
+    for(int s=0;s<5;s++)
+    {
+      GridMap2D map(getRandomGrid(sizes[s][0], sizes[s][1], 8));
+
+      // The top level can be coarser than the whole map
+      for(unsigned int levels=1;levels<=5;levels++)
+      {
+        map.updateClearancePyramid(levels);
+        checkSegments(map, 100);
+      }
+    }
+}
+
+
+TEST(gridMap2DTest, testSegmentOffMap){
+    srand(3);
+    GridMap2D map(getRandomGrid(16, 12, 5));
+    map.updateClearancePyramid(3);
+
+    // Map covers x in [-1, -0.2] and y in [2, 2.6]
+    EXPECT_FLOAT_EQ(-1, map.minClearanceAlongSegment(-2, 1, -1.5, 1.5));
+    EXPECT_FLOAT_EQ(-1, map.minClearanceAlongSegment(0, 1.9, 0, 3));
+    EXPECT_FLOAT_EQ(-1, map.minClearanceAlongSegment(-1.5, 2.7, 0.5, 2.9));
+    EXPECT_FALSE(map.isSegmentClear(-2, 1, -1.5, 1.5, 0.01));
+
+    // Crossing the whole map from outside
+    EXPECT_FLOAT_EQ(bruteSegment(map, -5, -3, 20, 15), map.minClearanceAlongSegment(-1.25, 1.85, 0, 2.75));
+}
+
+
+TEST(gridMap2DTest, testDisk){
+    srand(4);
+    GridMap2D map(getRandomGrid(20, 15, 10));
+    map.updateClearancePyramid(3);
+    const cv::Mat& level = map.clearancePyramid()[0];
+    const double res = map.getResolution();
+
+    for(unsigned int x=0;x<20;x++)
+    {
+      for(unsigned int y=0;y<15;y++)
+      {
+        double wx, wy;
+        map.mapToWorld(x, y, wx, wy);
+        EXPECT_FLOAT_EQ(level.at<float>(x, y), map.minClearanceInDisk(wx, wy, 0));
+
+        // A lower bound for the cells whose centers are in the disk
+        double radius = getRandom(0, 5*res);
+        float result = map.minClearanceInDisk(wx, wy, radius);
+        EXPECT_GE(result, 0);
+        for(int i=0;i<20;i++)
+        {
+          for(int j=0;j<15;j++)
+          {
+            if(res*res*((i-(int)x)*(i-(int)x) + (j-(int)y)*(j-(int)y)) <= radius*radius)
+            {
+              EXPECT_LE(result, level.at<float>(i, j) + 1e-5);
+            }
+          }
+        }
+      }
+    }
+
+    EXPECT_FLOAT_EQ(-1, map.minClearanceInDisk(-1.01, 2.1, 0.1));
+    EXPECT_FLOAT_EQ(-1, map.minClearanceInDisk(-0.5, 2.76, 0.1));
+}
+
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
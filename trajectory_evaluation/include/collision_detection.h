@@ -6,8 +6,14 @@
 #include "tf/transform_datatypes.h"
 #include "ramp_msgs/TrajectoryRequest.h"
 #include "ramp_msgs/Obstacle.h"
+#include "spatial_grid.h"
 #include <chrono>
 
+// Distance between two trajectory points that query treats as a collision
+#define QUERY_DIST_THRESHOLD 0.225
+
+// Cell size of the index over obstacle trajectory points
+#define OB_INDEX_CELL_SIZE 0.5
 
 
 
@@ -36,7 +42,14 @@ class CollisionDetection
     /***** Methods *****/ 
     void                        init();
     void                        perform(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, QueryResult& result); 
-    void                        performNum(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, const double& coll_dist, QueryResult& result); 
+    void                        performNum(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, const SpatialGrid& ob_index, const double& coll_dist, QueryResult& result); 
+
+    // Index the points of every obstacle trajectory, id = index of the obstacle
+    // The caller owns the index so requests with the same obstacles can share one
+    void                        buildObIndex(const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, SpatialGrid& result) const;
+
+    // True if a and b are the same obstacle trajectories, so an index built for one fits the other
+    const bool                  sameObstacles(const std::vector<ramp_msgs::RampTrajectory>& a, const std::vector<ramp_msgs::RampTrajectory>& b) const;
     
 
     /**
@@ -131,6 +144,9 @@ class CollisionDetection
 
     /***** Methods *****/
 
+    // Get the obstacles with a point within QUERY_DIST_THRESHOLD of some point on the trajectory, in ascending order
+    void getCandidateObs(const ramp_msgs::RampTrajectory& trajectory, const SpatialGrid& ob_index, const int num_obs, std::vector<int>& result) const;
+
     /***** Data Members *****/
     Utility                   utility_;
 };
@@ -0,0 +1,37 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+#include "utility.h"
+#include "nav_msgs/OccupancyGrid.h"
+
+// Cells with a higher occupancy are obstacles, same threshold as GridMap2D in ramp_sensing
+#define DISTANCE_FIELD_OCC_THRESHOLD 70
+
+
+/**
+ * Distance from each cell of a static map to the closest occupied cell, in meters.
+ * Built once per map, after that a lookup is a bilinear interpolation of the 
+ * four closest cell centers
+ */
+class DistanceField {
+  public:
+    DistanceField();
+
+    // Compute the field for grid, unknown cells are free
+    void build(const nav_msgs::OccupancyGrid& grid);
+
+    // Get the distance at (x,y), returns false if (x,y) is off the map
+    const bool lookup(const double x, const double y, double& result) const;
+
+    const bool built() const;
+
+  private:
+    nav_msgs::MapMetaData info_;
+
+    // Distance of each cell in meters, index = y*width + x
+    std::vector<float> dists_;
+
+    // Squared distance transform of one row or column (Felzenszwalb and Huttenlocher)
+    void transform1D(const std::vector<double>& f, std::vector<double>& d) const;
+};
+
+#endif
@@ -4,7 +4,10 @@
 #include "euclidean_distance.h"
 #include "orientation.h"
 #include "collision_detection.h"
+#include "distance_field.h"
 #include "utility.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 
 
@@ -14,8 +17,20 @@ class Evaluate {
     Evaluate();
 
     void perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationResponse& res);
-    void performFeasibility(ramp_msgs::EvaluationRequest& er);
-    void performFitness(ramp_msgs::RampTrajectory& trj, const double& offset, double& result);
+
+    // ob_index is the index of req.obstacle_trjs, see CollisionDetection::buildObIndex
+    void perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationResponse& res, const SpatialGrid& ob_index);
+
+    // static_clearance is set to the trajectory's clearance from the static map, -1 if it was not checked
+    void performFeasibility(ramp_msgs::EvaluationRequest& er, const SpatialGrid& ob_index, double& static_clearance);
+    void performFitness(ramp_msgs::RampTrajectory& trj, const double& offset, const double& static_clearance, double& result);
+
+    // Check trj against the static map, clearance is set to the min distance to the map before any collision
+    // Returns true if there is a collision and sets t_collision to its time
+    const bool performStatic(const DistanceField& map, const ramp_msgs::RampTrajectory& trj, double& t_collision, double& clearance);
+
+    // Replace the static map, it can be called while requests are being evaluated
+    void setStaticMap(const boost::shared_ptr<const DistanceField>& map);
 
     /** Different evaluation criteria */
     EuclideanDistance eucDist_;
@@ -33,6 +48,12 @@ class Evaluate {
     double Q_coll_;
     double Q_kine_;
 
+    // Static map, walls are checked against it instead of being sent as obstacles
+    // static_coll_dist_ is the robot radius, clearance under static_safe_dist_ is penalized by Q_clear_
+    double static_coll_dist_;
+    double static_safe_dist_;
+    double Q_clear_;
+
     bool imminent_collision_;
 
     std::vector< ros::Duration > t_analy_;
@@ -40,6 +61,9 @@ class Evaluate {
   private:
     Utility utility_;
     bool orientation_infeasible_;
+
+    boost::shared_ptr<const DistanceField> static_map_;
+    boost::mutex static_map_mutex_;
 };
 
 #endif
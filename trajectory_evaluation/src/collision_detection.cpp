@@ -9,17 +9,81 @@ CollisionDetection::~CollisionDetection()
 void CollisionDetection::init() {}
 
 
-void CollisionDetection::performNum(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, const double& coll_dist, QueryResult& result)
+void CollisionDetection::performNum(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, const SpatialGrid& ob_index, const double& coll_dist, QueryResult& result)
 {
   result.collision_ = false;
-  for(uint8_t i=0;i<obstacle_trjs.size() && !result.collision_;i++)
+
+  // Broad phase, only obstacles that come near the trajectory at some time can collide with it
+  std::vector<int> candidates;
+  getCandidateObs(trajectory, ob_index, obstacle_trjs.size(), candidates);
+
+  for(uint8_t i=0;i<candidates.size() && !result.collision_;i++)
   {
-    //////ROS_INFO("Ob traj: %s", utility_.toString(obstacle_trjs[i]).c_str());
-    query(trajectory.trajectory.points, obstacle_trjs[i].trajectory.points, trajectory.t_start.toSec(), coll_dist, result);
+    //////ROS_INFO("Ob traj: %s", utility_.toString(obstacle_trjs[candidates[i]]).c_str());
+    query(trajectory.trajectory.points, obstacle_trjs[candidates[i]].trajectory.points, trajectory.t_start.toSec(), coll_dist, result);
   }
 }
 
 
+const bool CollisionDetection::sameObstacles(const std::vector<ramp_msgs::RampTrajectory>& a, const std::vector<ramp_msgs::RampTrajectory>& b) const
+{
+  // Comparing the number of points and the first point is enough 
+  // because obstacle trajectories are predicted from their first point
+  bool same = a.size() == b.size();
+  for(uint8_t i=0;i<a.size() && same;i++)
+  {
+    const std::vector<trajectory_msgs::JointTrajectoryPoint>& p_a = a[i].trajectory.points;
+    const std::vector<trajectory_msgs::JointTrajectoryPoint>& p_b = b[i].trajectory.points;
+    same = p_a.size() == p_b.size() && (p_a.size() == 0 || 
+        (p_a[0].positions == p_b[0].positions && p_a[0].velocities == p_b[0].velocities));
+  }
+
+  return same;
+} // End sameObstacles
+
+
+void CollisionDetection::buildObIndex(const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, SpatialGrid& result) const
+{
+  result.clear();
+  result.setCellSize(OB_INDEX_CELL_SIZE);
+  for(uint8_t i=0;i<obstacle_trjs.size();i++)
+  {
+    for(int j=0;j<obstacle_trjs[i].trajectory.points.size();j++)
+    {
+      const std::vector<double>& p = obstacle_trjs[i].trajectory.points[j].positions;
+      result.insert(i, p.at(0), p.at(1));
+    }
+  }
+  result.build();
+} // End buildObIndex
+
+
+void CollisionDetection::getCandidateObs(const ramp_msgs::RampTrajectory& trajectory, const SpatialGrid& ob_index, const int num_obs, std::vector<int>& result) const
+{
+  result.clear();
+  std::vector<bool> near(num_obs, false);
+  std::vector<int> ids;
+  for(int i=0;i<trajectory.trajectory.points.size();i++)
+  {
+    const std::vector<double>& p = trajectory.trajectory.points[i].positions;
+    // Small margin because query compares float distances
+    ob_index.radius(p.at(0), p.at(1), QUERY_DIST_THRESHOLD + 0.001, ids);
+    for(int j=0;j<ids.size();j++)
+    {
+      near[ids[j]] = true;
+    }
+  }
+
+  for(int i=0;i<num_obs;i++)
+  {
+    if(near[i])
+    {
+      result.push_back(i);
+    }
+  }
+} // End getCandidateObs
+
+
 
 /** Returns true if trajectory_ is in collision with any of the objects */
 void CollisionDetection::perform(const ramp_msgs::RampTrajectory& trajectory, const std::vector<ramp_msgs::RampTrajectory>& obstacle_trjs, QueryResult& result)  
@@ -1650,8 +1714,8 @@ void CollisionDetection::query(const std::vector<trajectory_msgs::JointTrajector
   }*/
   
   // For every point, check circle detection on a subset of the obstacle's trajectory
-  float dist_threshold = coll_dist > 0.4 ? coll_dist : 0.225;
-  dist_threshold = 0.225;
+  float dist_threshold = coll_dist > 0.4 ? coll_dist : QUERY_DIST_THRESHOLD;
+  dist_threshold = QUERY_DIST_THRESHOLD;
 
   // Trajectories start in the future, obstacle trajectories start at the present time, 
   // set an offset for obstacle indices to account for this 
@@ -0,0 +1,127 @@
+#include "distance_field.h"
+
+
+DistanceField::DistanceField() {}
+
+
+void DistanceField::build(const nav_msgs::OccupancyGrid& grid)
+{
+  info_ = grid.info;
+  int w = info_.width;
+  int h = info_.height;
+
+  // Squared distances in cells, 0 at obstacles, "infinity" elsewhere
+  double inf = (double)(w+h) * (w+h);
+  std::vector<double> sq(w*h);
+  for(int i=0;i<w*h;i++)
+  {
+    sq[i] = grid.data[i] > DISTANCE_FIELD_OCC_THRESHOLD ? 0 : inf;
+  }
+
+  // Transform the columns then the rows
+  std::vector<double> f(h), d(h);
+  for(int x=0;x<w;x++)
+  {
+    for(int y=0;y<h;y++)
+    {
+      f[y] = sq[y*w + x];
+    }
+    transform1D(f, d);
+    for(int y=0;y<h;y++)
+    {
+      sq[y*w + x] = d[y];
+    }
+  }
+
+  f.resize(w);
+  d.resize(w);
+  for(int y=0;y<h;y++)
+  {
+    std::copy(sq.begin() + y*w, sq.begin() + (y+1)*w, f.begin());
+    transform1D(f, d);
+    std::copy(d.begin(), d.end(), sq.begin() + y*w);
+  }
+
+  dists_.resize(w*h);
+  for(int i=0;i<w*h;i++)
+  {
+    dists_[i] = sqrt(sq[i]) * info_.resolution;
+  }
+} // End build
+
+
+/** Lower envelope of the parabolas rooted at each f[q] */
+void DistanceField::transform1D(const std::vector<double>& f, std::vector<double>& d) const
+{
+  int n = f.size();
+  std::vector<int> v(n);
+  std::vector<double> z(n+1);
+  int k = 0;
+  v[0] = 0;
+  z[0] = -std::numeric_limits<double>::max();
+  z[1] = std::numeric_limits<double>::max();
+
+  for(int q=1;q<n;q++)
+  {
+    double s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+    while(s <= z[k])
+    {
+      k--;
+      s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+    }
+    k++;
+    v[k]    = q;
+    z[k]    = s;
+    z[k+1]  = std::numeric_limits<double>::max();
+  }
+
+  k = 0;
+  for(int q=0;q<n;q++)
+  {
+    while(z[k+1] < q)
+    {
+      k++;
+    }
+    d[q] = (q - v[k])*(q - v[k]) + f[v[k]];
+  }
+} // End transform1D
+
+
+const bool DistanceField::lookup(const double x, const double y, double& result) const
+{
+  if(dists_.size() == 0)
+  {
+    return false;
+  }
+
+  // Position in cells, distances are at the cell centers
+  double u = (x - info_.origin.position.x) / info_.resolution;
+  double v = (y - info_.origin.position.y) / info_.resolution;
+  int w = info_.width;
+  int h = info_.height;
+  if(u < 0 || v < 0 || u >= w || v >= h)
+  {
+    return false;
+  }
+
+  u -= 0.5;
+  v -= 0.5;
+  int i = u < 0 ? 0 : u > w-2 ? (w > 1 ? w-2 : 0) : (int)u;
+  int j = v < 0 ? 0 : v > h-2 ? (h > 1 ? h-2 : 0) : (int)v;
+  int i1 = i+1 < w ? i+1 : i;
+  int j1 = j+1 < h ? j+1 : j;
+  double a = u - i;
+  double b = v - j;
+  a = a < 0 ? 0 : a > 1 ? 1 : a;
+  b = b < 0 ? 0 : b > 1 ? 1 : b;
+
+  result =  (1-a)*(1-b)*dists_[j*w + i]   + a*(1-b)*dists_[j*w + i1] + 
+            (1-a)*b*dists_[j1*w + i]      + a*b*dists_[j1*w + i1];
+  return true;
+} // End lookup
+
+
+const bool DistanceField::built() const
+{
+  return dists_.size() > 0;
+}
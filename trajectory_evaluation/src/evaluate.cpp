@@ -1,8 +1,53 @@
 #include "evaluate.h"
 
-Evaluate::Evaluate() : Q_coll_(10000.f), Q_kine_(100000.f), orientation_infeasible_(0) {}
+Evaluate::Evaluate() : Q_coll_(10000.f), Q_kine_(100000.f), static_coll_dist_(0.2), static_safe_dist_(0.5), Q_clear_(5.f), 
+  orientation_infeasible_(0) {}
+
+
+void Evaluate::setStaticMap(const boost::shared_ptr<const DistanceField>& map)
+{
+  boost::mutex::scoped_lock lock(static_map_mutex_);
+  static_map_ = map;
+}
+
+
+/** Check each point of trj against the static map, one lookup per point */
+const bool Evaluate::performStatic(const DistanceField& map, const ramp_msgs::RampTrajectory& trj, double& t_collision, double& clearance)
+{
+  clearance = -1;
+  for(int i=0;i<trj.trajectory.points.size();i++)
+  {
+    double d;
+    const trajectory_msgs::JointTrajectoryPoint& p = trj.trajectory.points[i];
+    if(!map.lookup(p.positions.at(0), p.positions.at(1), d))
+    {
+      continue;
+    }
+
+    if(clearance < 0 || d < clearance)
+    {
+      clearance = d;
+    }
+
+    if(d < static_coll_dist_)
+    {
+      t_collision = p.time_from_start.toSec();
+      return true;
+    }
+  }
+
+  return false;
+} // End performStatic
 
 void Evaluate::perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationResponse& res)
+{
+  SpatialGrid ob_index;
+  cd_.buildObIndex(req.obstacle_trjs, ob_index);
+  perform(req, res, ob_index);
+}
+
+
+void Evaluate::perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationResponse& res, const SpatialGrid& ob_index)
 {
   ////ROS_INFO("In Evaluate::perform()");
   //ros::Time t_start = ros::Time::now();
@@ -18,7 +63,9 @@ void Evaluate::perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationR
   // Reset orientation_infeasible for new trajectory
   orientation_infeasible_ = false;
 
-  performFeasibility(req);
+  // Per request, requests can be evaluated concurrently
+  double static_clearance;
+  performFeasibility(req, ob_index, static_clearance);
   ////ROS_INFO("qr_.collision: %s orientation_infeasible_: %s", qr_.collision_ ? "True" : "False", orientation_infeasible_ ? "True" : "False");
   req.trajectory.feasible = !qr_.collision_ && !orientation_infeasible_;
   res.feasible = !qr_.collision_ && !orientation_infeasible_;
@@ -40,7 +87,7 @@ void Evaluate::perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationR
   if(req.full_eval)
   {
     //////ROS_INFO("Requesting fitness!");
-    performFitness(req.trajectory, req.offset, res.fitness);
+    performFitness(req.trajectory, req.offset, static_clearance, res.fitness);
   }
   else
   {
@@ -52,17 +99,32 @@ void Evaluate::perform(ramp_msgs::EvaluationRequest& req, ramp_msgs::EvaluationR
 
 // Redo this method at some point
 // It's modiftying trj AND returning a value
-void Evaluate::performFeasibility(ramp_msgs::EvaluationRequest& er) 
+void Evaluate::performFeasibility(ramp_msgs::EvaluationRequest& er, const SpatialGrid& ob_index, double& static_clearance) 
 {
   ////ROS_INFO("In Evaluate::performFeasibility");
   ros::Time t_start = ros::Time::now();
 
   // Check collision
   ros::Time t_numeric_start = ros::Time::now();
-  cd_.performNum(er.trajectory, er.obstacle_trjs, er.coll_dist, qr_);
+  cd_.performNum(er.trajectory, er.obstacle_trjs, ob_index, er.coll_dist, qr_);
   ros::Duration d_numeric   = ros::Time::now() - t_numeric_start;
   t_numeric_.push_back(d_numeric);
 
+  // Check the static map, keep whichever collision comes first
+  boost::shared_ptr<const DistanceField> static_map;
+  {
+    boost::mutex::scoped_lock lock(static_map_mutex_);
+    static_map = static_map_;
+  }
+  static_clearance = -1;
+  double t_static;
+  if(static_map && performStatic(*static_map, er.trajectory, t_static, static_clearance) && 
+      (!qr_.collision_ || t_static < qr_.t_firstCollision_))
+  {
+    qr_.collision_          = true;
+    qr_.t_firstCollision_   = t_static;
+  }
+
   ////ROS_INFO("result.collision: %s", qr_.collision_ ? "True" : "False");
   /*ros::Time t_analy_start = ros::Time::now();
   cd_.perform(er.trajectory, er.obstacle_trjs, qr_);
@@ -129,7 +191,7 @@ void Evaluate::performFeasibility(ramp_msgs::EvaluationRequest& er)
 
 
 /** This method computes the fitness of the trajectory_ member */
-void Evaluate::performFitness(ramp_msgs::RampTrajectory& trj, const double& offset, double& result) 
+void Evaluate::performFitness(ramp_msgs::RampTrajectory& trj, const double& offset, const double& static_clearance, double& result) 
 {
   //ROS_INFO("In Evaluate::performFitness");
   ros::Time t_start = ros::Time::now();
@@ -207,8 +269,15 @@ void Evaluate::performFitness(ramp_msgs::RampTrajectory& trj, const double& offs
     // Orientation
     double A = orientation_.perform(trj);
     
-    //ROS_INFO("T: %f A: %f", T, A);
-    cost = T + A;
+    // Clearance from the static map
+    double C = 0;
+    if(static_clearance >= 0 && static_clearance < static_safe_dist_)
+    {
+      C = Q_clear_ * (static_safe_dist_ - static_clearance) / static_safe_dist_;
+    }
+
+    //ROS_INFO("T: %f A: %f C: %f", T, A, C);
+    cost = T + A + C;
   }
 
   else
@@ -3,6 +3,9 @@
 #include "evaluate.h"
 #include "tf/transform_datatypes.h"
 #include "ramp_msgs/Obstacle.h"
+#include "shm_ring.h"
+#include <boost/thread.hpp>
+#include <sched.h>
 
 Evaluate ev;
 Utility u;
@@ -11,10 +14,36 @@ std::vector<ros::Duration> t_data;
 int count_multiple = 0;
 int count_single = 0;
 
+// Slots in each shared memory ring, the planner has one request in flight at a time
+#define SHM_NUM_SLOTS 4
+
+// Polls of an empty request ring before the loop starts sleeping between them
+#define SHM_SPIN_POLLS 2000
+
+ShmRing ring_requests;
+ShmRing ring_results;
+
+// Held for each batch, the service callbacks and shmLoop share ev and the statistics
+boost::mutex mutex_eval;
+
+/** Build the distance field of a new static map */
+void staticMapCb(const nav_msgs::OccupancyGridConstPtr& grid)
+{
+  ros::Time t_start = ros::Time::now();
+
+  boost::shared_ptr<DistanceField> map(new DistanceField);
+  map->build(*grid);
+  ev.setStaticMap(map);
+
+  ROS_INFO("Built static distance field (%i x %i) in %f s", (int)grid->info.width, (int)grid->info.height, (ros::Time::now() - t_start).toSec());
+} // End staticMapCb
+
+
 /** Srv callback to evaluate a trajectory */
 bool handleRequest(ramp_msgs::EvaluationSrv::Request& reqs,
                    ramp_msgs::EvaluationSrv::Response& resps) 
 {
+  boost::mutex::scoped_lock lock(mutex_eval);
   int s = reqs.reqs.size();
 
   if(s > 1)
@@ -29,6 +58,11 @@ bool handleRequest(ramp_msgs::EvaluationSrv::Request& reqs,
 
   ros::Time t_start = ros::Time::now();
   ros::Duration t_elapsed;
+
+  // Requests in a batch usually share their obstacles, index them once per batch
+  // The index is local so concurrent batches never share one
+  SpatialGrid ob_index;
+  int i_indexed = -1;
   for(uint8_t i=0;i<s;i++)
   {
     //t_start = ros::Time::now();
@@ -44,7 +78,12 @@ bool handleRequest(ramp_msgs::EvaluationSrv::Request& reqs,
     if(reqs.reqs.at(i).trajectory.trajectory.points.size() > 1)
     {
       ////////ROS_INFO("More than 1 point, performing evaluation");
-      ev.perform(reqs.reqs[i], res);
+      if(i_indexed < 0 || !ev.cd_.sameObstacles(reqs.reqs[i].obstacle_trjs, reqs.reqs[i_indexed].obstacle_trjs))
+      {
+        ev.cd_.buildObIndex(reqs.reqs[i].obstacle_trjs, ob_index);
+        i_indexed = i;
+      }
+      ev.perform(reqs.reqs[i], res, ob_index);
     }
     // Else we only have one point (goal point)
     else
@@ -70,6 +109,44 @@ bool handleRequest(ramp_msgs::EvaluationSrv::Request& reqs,
 } //End handleRequest
 
 
+/**
+ * Serve requests from the planner's shared memory ring with the same code 
+ * as the service, answering on the result ring with the request's sequence
+ * number
+ */
+void shmLoop()
+{
+  ramp_msgs::EvaluationSrv::Request reqs;
+  ramp_msgs::EvaluationSrv::Response resps;
+  uint32_t seq;
+  int polls = 0;
+  while(ros::ok())
+  {
+    if(ring_requests.pop(seq, reqs))
+    {
+      resps.resps.clear();
+      handleRequest(reqs, resps);
+
+      // Only full if the planner gave up on earlier results, it uses the service then
+      if(!ring_results.push(seq, resps))
+      {
+        ROS_WARN("Shared memory result ring full, dropping result %u", seq);
+      }
+      polls = 0;
+    }
+    else if(polls < SHM_SPIN_POLLS)
+    {
+      polls++;
+      sched_yield();
+    }
+    else
+    {
+      ros::WallDuration(0.00005).sleep();
+    }
+  }
+} // End shmLoop
+
+
 void reportData(int sig)
 {
 
@@ -221,6 +298,37 @@ int main(int argc, char** argv) {
  
   ros::ServiceServer service    = handle.advertiseService("trajectory_evaluation", handleRequest);
 
+  // Static map for the clearance term, the map server latches it so it arrives once
+  std::string static_map_topic;
+  handle.param("ramp/static_map_topic", static_map_topic, std::string("/map"));
+  handle.param("ramp/static_coll_dist", ev.static_coll_dist_, ev.static_coll_dist_);
+  ros::Subscriber sub_static_map;
+  if(static_map_topic.size() > 0)
+  {
+    sub_static_map = handle.subscribe(static_map_topic, 1, &staticMapCb);
+  }
+
+  // Optional shared memory transport for a planner on the same host
+  bool use_shm;
+  std::string shm_name;
+  int shm_slot_size;
+  handle.param("ramp/eval_shared_memory", use_shm, false);
+  handle.param("ramp/eval_shm_name", shm_name, std::string("ramp_eval"));
+  handle.param("ramp/eval_shm_slot_size", shm_slot_size, 1<<22);
+  boost::thread shm_thread;
+  if(use_shm)
+  {
+    if(ring_results.create(shm_name + "_results", SHM_NUM_SLOTS, shm_slot_size) &&
+        ring_requests.create(shm_name + "_requests", SHM_NUM_SLOTS, shm_slot_size))
+    {
+      shm_thread = boost::thread(&shmLoop);
+    }
+    else
+    {
+      ROS_ERROR("Could not create the shared memory rings %s, serving the service only", shm_name.c_str());
+    }
+  }
+
   signal(SIGINT, reportData);
   //cd.pub_population = handle.advertise<ramp_msgs::Population>("/robot_1/population", 1000);
 
@@ -234,6 +342,13 @@ int main(int argc, char** argv) {
 
   //ros::spin();
 
+  if(shm_thread.joinable())
+  {
+    shm_thread.join();
+    ShmRing::remove(shm_name + "_requests");
+    ShmRing::remove(shm_name + "_results");
+  }
+
   printf("\nTrajectory Evaluation exiting normally\n");
   return 0;
 }
@@ -10,6 +10,9 @@
 
 // include header file of the fixture tests
 #include "trajectory_evaluation_fixtureTest.h"
+#include "spatial_grid.h"
+#include "distance_field.h"
+#include <algorithm>
 
 
 TEST_F(trajectoryEvaluationFixtureTest, testEvaluationRequest_JointTrajectory_With_One_Point){
@@ -1149,6 +1152,263 @@ TEST_F(trajectoryEvaluationFixtureTest, testEvaluationRequest_JointTrajectory_Wi
 }
 
 
+//============= SpatialGrid ===================================================
+
+/** Brute force reference for the SpatialGrid queries */
+struct GridPoint { int id; double x, y; };
+
+std::vector<GridPoint> getRandomPoints(const int n)
+{
+  std::vector<GridPoint> result;
+  for(int i=0;i<n;i++)
+  {
+    GridPoint p;
+    p.id = i;
+    p.x  = -5. + 10. * rand() / RAND_MAX;
+    p.y  = -5. + 10. * rand() / RAND_MAX;
+    result.push_back(p);
+  }
+  return result;
+}
+
+void buildGrid(const std::vector<GridPoint>& points, const double cell_size, SpatialGrid& result)
+{
+  result.clear();
+  result.setCellSize(cell_size);
+  for(int i=0;i<points.size();i++)
+  {
+    result.insert(points[i].id, points[i].x, points[i].y);
+  }
+  result.build();
+}
+
+/** Ids of the points within r of the segment (x0,y0)-(x1,y1), sorted */
+std::vector<int> bruteCorridor(const std::vector<GridPoint>& points, const double x0, const double y0, const double x1, const double y1, const double r)
+{
+  std::vector<int> result;
+  double dx = x1-x0, dy = y1-y0, l2 = dx*dx + dy*dy;
+  for(int i=0;i<points.size();i++)
+  {
+    double t = l2 > 0 ? ((points[i].x-x0)*dx + (points[i].y-y0)*dy) / l2 : 0;
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+    if(sqrt(pow(x0 + t*dx - points[i].x, 2) + pow(y0 + t*dy - points[i].y, 2)) <= r)
+    {
+      result.push_back(points[i].id);
+    }
+  }
+  return result;
+}
+
+
+TEST(spatialGridTest, testEmptyGrid){
+    SpatialGrid grid(0.5);
+    grid.build();
+
+    double dist;
+    std::vector<int> ids(1, 7);
+    EXPECT_EQ(-1, grid.nearest(0, 0, dist));
+    grid.radius(0, 0, 10, ids);
+    EXPECT_TRUE(ids.empty());
+    grid.corridor(0, 0, 1, 1, 10, ids);
+    EXPECT_TRUE(ids.empty());
+}
+
+
+TEST(spatialGridTest, testNearest){
+    srand(1);
+    std::vector<GridPoint> points = getRandomPoints(200);
+    SpatialGrid grid;
+    buildGrid(points, 0.5, grid);
+    ASSERT_EQ(200u, grid.size());
+
+    // Queries inside and well outside the points' bounding box
+    for(int q=0;q<100;q++)
+    {
+        double x = -8. + 16. * rand() / RAND_MAX;
+        double y = -8. + 16. * rand() / RAND_MAX;
+
+        double d_brute = -1;
+        for(int i=0;i<points.size();i++)
+        {
+            double d = sqrt(pow(points[i].x - x, 2) + pow(points[i].y - y, 2));
+            d_brute = (d_brute < 0 || d < d_brute) ? d : d_brute;
+        }
+
+        double dist;
+        int id = grid.nearest(x, y, dist);
+        ASSERT_GE(id, 0);
+        EXPECT_NEAR(d_brute, dist, 1e-9);
+        EXPECT_NEAR(dist, sqrt(pow(points[id].x - x, 2) + pow(points[id].y - y, 2)), 1e-9);
+    }
+}
+
+
+TEST(spatialGridTest, testRadius){
+    srand(2);
+    std::vector<GridPoint> points = getRandomPoints(200);
+    SpatialGrid grid;
+    buildGrid(points, 0.5, grid);
+
+    double radii[] = {0.1, 0.5, 1.3, 20};
+    for(int q=0;q<100;q++)
+    {
+        double x = -6. + 12. * rand() / RAND_MAX;
+        double y = -6. + 12. * rand() / RAND_MAX;
+        double r = radii[q % 4];
+
+        std::vector<int> ids;
+        grid.radius(x, y, r, ids);
+        std::sort(ids.begin(), ids.end());
+        EXPECT_EQ(bruteCorridor(points, x, y, x, y, r), ids);
+    }
+}
+
+
+TEST(spatialGridTest, testCorridor){
+    srand(3);
+    std::vector<GridPoint> points = getRandomPoints(200);
+    SpatialGrid grid;
+    buildGrid(points, 0.5, grid);
+
+    for(int q=0;q<100;q++)
+    {
+        double x0 = -6. + 12. * rand() / RAND_MAX;
+        double y0 = -6. + 12. * rand() / RAND_MAX;
+        double x1 = -6. + 12. * rand() / RAND_MAX;
+        double y1 = -6. + 12. * rand() / RAND_MAX;
+        double r  = 0.05 + 0.5 * rand() / RAND_MAX;
+
+        std::vector<int> ids;
+        grid.corridor(x0, y0, x1, y1, r, ids);
+        std::sort(ids.begin(), ids.end());
+        EXPECT_EQ(bruteCorridor(points, x0, y0, x1, y1, r), ids);
+    }
+}
+
+
+TEST(spatialGridTest, testSharedIds){
+    // Several points with one id, like the points of one obstacle trajectory
+    SpatialGrid grid(1.);
+    grid.insert(0, 0, 0);
+    grid.insert(0, 0.2, 0);
+    grid.insert(1, 3, 3);
+    grid.build();
+
+    std::vector<int> ids;
+    grid.radius(0.1, 0, 0.5, ids);
+    ASSERT_EQ(2u, ids.size());
+    EXPECT_EQ(0, ids[0]);
+    EXPECT_EQ(0, ids[1]);
+
+    grid.corridor(0, 0, 3, 3, 0.01, ids);
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(2u, ids.size());
+    EXPECT_EQ(0, ids[0]);
+    EXPECT_EQ(1, ids[1]);
+}
+
+
+
+//============= DistanceField =================================================
+
+/** Grid of w x h free cells, 0.1m cells with the origin at (1,2) */
+nav_msgs::OccupancyGrid getFreeGrid(const int w, const int h)
+{
+  nav_msgs::OccupancyGrid result;
+  result.info.width       = w;
+  result.info.height      = h;
+  result.info.resolution  = 0.1;
+  result.info.origin.position.x = 1;
+  result.info.origin.position.y = 2;
+  result.data.assign(w*h, 0);
+  return result;
+}
+
+/** Distance in meters from the center of cell (x,y) to the closest occupied cell center */
+double bruteDistance(const nav_msgs::OccupancyGrid& grid, const int x, const int y)
+{
+  double result = -1;
+  for(int j=0;j<grid.info.height;j++)
+  {
+    for(int i=0;i<grid.info.width;i++)
+    {
+      if(grid.data[j*grid.info.width + i] > DISTANCE_FIELD_OCC_THRESHOLD)
+      {
+        double d = sqrt((double)(i-x)*(i-x) + (j-y)*(j-y)) * grid.info.resolution;
+        result = (result < 0 || d < result) ? d : result;
+      }
+    }
+  }
+  return result;
+}
+
+
+TEST(distanceFieldTest, testSingleObstacle){
+    nav_msgs::OccupancyGrid grid = getFreeGrid(20, 10);
+    grid.data[3*20 + 5] = 100;
+
+    DistanceField field;
+    EXPECT_FALSE(field.built());
+    field.build(grid);
+    EXPECT_TRUE(field.built());
+
+    double d;
+    // Center of the occupied cell
+    ASSERT_TRUE(field.lookup(1.55, 2.35, d));
+    EXPECT_NEAR(0, d, 1e-6);
+
+    // Center of the cell 3 right and 4 up of it
+    ASSERT_TRUE(field.lookup(1.85, 2.75, d));
+    EXPECT_NEAR(0.5, d, 1e-6);
+
+    // Halfway between two cell centers on the same row is their average
+    ASSERT_TRUE(field.lookup(1.60, 2.35, d));
+    EXPECT_NEAR(0.05, d, 1e-6);
+}
+
+
+TEST(distanceFieldTest, testMatchesBruteForce){
+    srand(4);
+    nav_msgs::OccupancyGrid grid = getFreeGrid(30, 25);
+    for(int i=0;i<grid.data.size();i++)
+    {
+      int r = rand() % 100;
+      // Unknown cells (-1) count as free
+      grid.data[i] = r < 3 ? 100 : r < 10 ? -1 : 0;
+    }
+
+    DistanceField field;
+    field.build(grid);
+
+    for(int y=0;y<grid.info.height;y++)
+    {
+      for(int x=0;x<grid.info.width;x++)
+      {
+        double d;
+        ASSERT_TRUE(field.lookup(1 + (x+0.5)*0.1, 2 + (y+0.5)*0.1, d));
+        EXPECT_NEAR(bruteDistance(grid, x, y), d, 1e-5);
+      }
+    }
+}
+
+
+TEST(distanceFieldTest, testOffMap){
+    nav_msgs::OccupancyGrid grid = getFreeGrid(20, 10);
+    grid.data[0] = 100;
+
+    double d;
+    DistanceField field;
+    EXPECT_FALSE(field.lookup(1.5, 2.5, d));
+
+    field.build(grid);
+    EXPECT_FALSE(field.lookup(0.99, 2.5, d));
+    EXPECT_FALSE(field.lookup(1.5, 1.99, d));
+    EXPECT_FALSE(field.lookup(3.01, 2.5, d));
+    EXPECT_FALSE(field.lookup(1.5, 3.01, d));
+    EXPECT_TRUE(field.lookup(2.99, 2.99, d));
+}
+
+
 //============= Main function of test runer ===================================
 int main(int argc, char **argv) {
     
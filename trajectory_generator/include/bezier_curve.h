@@ -2,6 +2,7 @@
 #define BEZIER_CURVE
 
 #include "utility.h"
+#include "sample_buffer.h"
 
 
 class BezierCurve {
@@ -12,11 +13,15 @@ public:
   ~BezierCurve();
 
   void init(const ramp_msgs::BezierCurve bi, const ramp_msgs::MotionState ms_current);
+
+  // Only set up what verify() needs, Reflexxes is not initialized
+  void initGeometry(const ramp_msgs::BezierCurve bi);
  
  
 
   const std::vector<ramp_msgs::MotionState> generateCurve();
   void generateCurveOOP();
+  void generateCurveOOP(SampleBuffer& samples);
 
   const bool verify() const;
  
@@ -68,7 +73,7 @@ private:
 
   const bool finalStateReached() const;
 
-  const ramp_msgs::MotionState spinOnce();
+  void spinOnce(MotionSample& result);
 
   void dealloc();
 
@@ -89,7 +94,7 @@ private:
 
   // TODO: Make const
   const ramp_msgs::MotionState buildMotionState(const ReflexxesData data);
-  void buildMotionStateOOP(const ReflexxesData& data, ramp_msgs::MotionState& result);
+  void buildMotionStateOOP(const ReflexxesData& data, MotionSample& result);
 
   const ReflexxesData adjustTargets(const ReflexxesData data) const;
 };
@@ -1,6 +1,8 @@
 #ifndef CIRCLE_H
 #define CIRCLE_H
 #include "utility.h"
+#include "sample_buffer.h"
+#include "planar_profile.h"
 
 #define CYCLE_TIME_IN_SECONDS 0.1
 
@@ -10,7 +12,7 @@ public:
   Circle();
   ~Circle();
 
-  const std::vector<ramp_msgs::MotionState>   generatePoints();
+  void generatePoints(SampleBuffer& result);
   void init(const ramp_msgs::MotionState s);
 private:
   ReflexxesData reflexxesData_;
@@ -20,14 +22,21 @@ private:
 
   void initReflexxes();
 
-  const ramp_msgs::MotionState buildMotionState(const ReflexxesData data);
+  void buildMotionState(const ReflexxesData& data, MotionSample& result);
+  void buildMotionState(const double phi, const double w, MotionSample& result);
   
   // Initialize variables just after receiving a service request
   void setReflexxesCurrent();
   void setReflexxesTarget();
   void setReflexxesSelection();
   
-  const ramp_msgs::MotionState spinOnce();
+  void spinOnce(MotionSample& result);
+
+  // Native replacement for Reflexxes, used when built with USE_NATIVE_PROFILE
+  Profile1D profile_;
+  double    w_prev_;
+  void initProfile();
+  void spinOnceProfile(MotionSample& result);
 
   // Returns true if the target has been reached
   const bool finalStateReached();
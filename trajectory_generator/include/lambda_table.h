@@ -0,0 +1,68 @@
+#ifndef LAMBDA_TABLE_H
+#define LAMBDA_TABLE_H
+
+#include "bezier_curve.h"
+#include "utility.h"
+
+// Table dimensions
+#define LAMBDA_TABLE_N_HEADING  12  // Heading of the first segment, [-PI, PI]
+#define LAMBDA_TABLE_N_TURN     12  // Turn between the two segments, [-PI, PI]
+#define LAMBDA_TABLE_N_RATIO    8   // log2 of segment 2 length / segment 1 length, [-4, 4]
+#define LAMBDA_TABLE_N_LENGTH   8   // log2 of segment 1 length, [-3, 5]
+
+
+/**
+ * Precomputed control point lambda values for Bezier curves
+ *
+ * Each cell holds the lambda that the iterative search in MobileBase
+ * (lambdaOkay + BezierCurve::verify) settles on for a canonical curve whose
+ * segments fall in that cell, or a negative value if no lambda was valid.
+ * The table is built once at startup for the default motion limits and is
+ * read-only afterwards, so one instance can be shared by concurrent requests.
+ * A lookup is only a candidate: callers still verify the curve and fall back
+ * to the search when the candidate is rejected.
+ */
+class LambdaTable {
+public:
+
+  LambdaTable();
+  ~LambdaTable();
+
+  // Fill the table for curves with the given max velocities and accelerations
+  void build(const ramp_msgs::MotionState& ms_maxVA);
+
+  // Get the candidate lambda for segment_points, returns false if there is none
+  // or if ms_maxVA differs from the limits the table was built for
+  const bool lookup(const std::vector<ramp_msgs::MotionState>& segment_points, const ramp_msgs::MotionState& ms_maxVA, 
+      const bool transition, double& lambda) const;
+
+  const bool built() const;
+
+private:
+
+  Utility utility_;
+  bool built_;
+  ramp_msgs::MotionState ms_maxVA_;
+
+  // Indexed by getIndex, one table for transition curves and one for the others
+  std::vector<double> hybrid_;
+  std::vector<double> transition_;
+
+  const int getIndex(const int i_heading, const int i_turn, const int i_ratio, const int i_length) const;
+
+  // Bucket of a value in [min, max] split into n cells, clamped to the table
+  const int getBucket(const double value, const double min, const double max, const int n) const;
+
+  const bool sameLimits(const ramp_msgs::MotionState& ms_maxVA) const;
+
+  // Center value of a bucket
+  const double getBucketCenter(const int i, const double min, const double max, const int n) const;
+
+  // Run the same search as MobileBase for one canonical curve
+  const double search(const std::vector<ramp_msgs::MotionState>& segment_points, const ramp_msgs::MotionState& ms_maxVA, const bool transition) const;
+
+  // Geometric part of MobileBase::lambdaOkay
+  const bool shapeOkay(const std::vector<ramp_msgs::MotionState>& segment_points, const double lambda) const;
+};
+
+#endif
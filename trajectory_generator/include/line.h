@@ -1,6 +1,8 @@
 #ifndef LINE_H
 #define LINE_H
 #include "utility.h"
+#include "sample_buffer.h"
+#include "planar_profile.h"
 
 #define CYCLE_TIME_IN_SECONDS 0.1
 
@@ -10,7 +12,7 @@ public:
   Line();
   ~Line();
 
-  const std::vector<ramp_msgs::MotionState>   generatePoints();
+  void generatePoints(SampleBuffer& result);
   void init(const ramp_msgs::MotionState start, 
             const ramp_msgs::MotionState goal);
 
@@ -22,7 +24,7 @@ private:
   ros::Duration timeCutoff_;
   Utility utility_;
 
-  const ramp_msgs::MotionState buildMotionState(const ReflexxesData data);
+  void buildMotionState(const ReflexxesData& data, MotionSample& result);
 
   void initReflexxes();
 
@@ -31,7 +33,13 @@ private:
   void setReflexxesTarget();
   void setReflexxesSelection();
   
-  const ramp_msgs::MotionState spinOnce();
+  void spinOnce(MotionSample& result);
+
+  // Native replacement for Reflexxes, used when built with USE_NATIVE_PROFILE
+  PlanarProfile profile_;
+  MotionSample  current_;
+  void initProfile();
+  void spinOnceProfile(MotionSample& result);
 
   // Returns true if the target has been reached
   const bool finalStateReached();
@@ -4,15 +4,43 @@
 #include "ramp_msgs/TrajectoryRequest.h"
 #include "tf/transform_datatypes.h"
 #include "bezier_curve.h"
+#include "lambda_table.h"
+#include "sample_buffer.h"
 #include "utility.h"
 
 
 
+/**
+ * First straight segment of a trajectory and the Reflexxes state after it
+ * Requests in one batch usually start from the same state, so a MobileBase
+ * that serves several requests generates this segment once and reuses it
+ */
+struct StartSegment {
+  bool valid;
+
+  // What the segment was generated from
+  uint8_t type;
+  bool two_points;
+  ramp_msgs::MotionState start, first;
+
+  // Trajectory up to the first knot point
+  std::vector<trajectory_msgs::JointTrajectoryPoint> points;
+  std::vector<uint16_t> i_knotPoints;
+
+  // State to continue from
+  trajectory_msgs::JointTrajectoryPoint prevKP;
+  ros::Duration timeFromStart;
+  int resultValue;
+  RMLPositionInputParameters*   inputParameters;
+  RMLPositionOutputParameters*  outputParameters;
+};
+
+
 class MobileBase {
 
 public:
 
-  MobileBase();
+  MobileBase(const LambdaTable* lambdaTable=0);
   ~MobileBase();
 
   // Service callback, the input is a path and the output a trajectory
@@ -23,6 +51,9 @@ public:
   const std::vector<BezierCurve> bezier(ramp_msgs::Path& p, const bool only_curve);
   void bezierOOP(ramp_msgs::Path& p, bool only_curve, std::vector<BezierCurve>& result);
 
+  // Limits used for requests that do not give their own
+  const ramp_msgs::MotionState getDefaultMaxMS();
+
 
   TrajectoryType type_;
   bool print_;
@@ -57,6 +88,15 @@ private:
   // Utility
   Utility utility_;
 
+  // Precomputed lambda values, not owned
+  const LambdaTable* lambdaTable_;
+
+  // Scratch samples for the curves of this request
+  SampleBuffer samples_;
+
+  // Shared by the requests this object serves
+  StartSegment startSegment_;
+
 
   bool bezierStart;
 
@@ -77,6 +117,19 @@ private:
   // Initialize everything
   void init(const ramp_msgs::TrajectoryRequest req);
 
+  // Forget the previous request so the object can serve another one
+  void reset();
+
+  // Save or restore the first segment of the trajectory, restore returns false if the
+  // saved segment was generated for a different start
+  void saveStartSegment(const ramp_msgs::TrajectoryRequest& req, const ramp_msgs::TrajectoryResponse& res);
+  const bool restoreStartSegment(const ramp_msgs::TrajectoryRequest& req, ramp_msgs::TrajectoryResponse& res);
+  const bool sameMotionState(const ramp_msgs::MotionState& a, const ramp_msgs::MotionState& b) const;
+
+  // Copy the Reflexxes inputs and outputs that a trajectory continues from
+  void copyReflexxesState(const RMLPositionInputParameters& in, const RMLPositionOutputParameters& out,
+      RMLPositionInputParameters& in_result, RMLPositionOutputParameters& out_result) const;
+
   // Set the target of the Reflexxes library
   void setTarget(const ramp_msgs::MotionState& ms);
   void setMaxV(const double x_dot, const double theta_dot=3.f*PI/4.f);
@@ -94,10 +147,16 @@ private:
   void insertPoint(const ramp_msgs::MotionState& ms, ramp_msgs::TrajectoryResponse& res);
   void insertPoint(const trajectory_msgs::JointTrajectoryPoint& jp, ramp_msgs::TrajectoryResponse& res);
 
+  // Append a sample to the back of points
+  void appendPoint(const MotionSample& s, std::vector<trajectory_msgs::JointTrajectoryPoint>& points) const;
+
+  // Set the Reflexxes current state to jp
+  void setCurrent(const trajectory_msgs::JointTrajectoryPoint& jp);
+
   
 
   // Execute one iteration of the Reflexxes control function
-  const trajectory_msgs::JointTrajectoryPoint spinOnce(bool vertical_line=false);
+  void spinOnce(MotionSample& point, bool vertical_line=false);
 
   // Returns true if the target has been reached
   bool finalStateReached() const;
@@ -113,13 +172,14 @@ private:
   void setSelectionVectorRotation();
 
   // Get a valid lambda value for a curve over segment_points
-  const double getControlPointLambda(const std::vector<ramp_msgs::MotionState> segment_points) const;
+  // If useTable is true, a verified lambda from lambdaTable_ is tried before searching
+  const double getControlPointLambda(const std::vector<ramp_msgs::MotionState> segment_points, const bool useTable=false) const;
 
   // Check if a lambda value is valid for segment_points
   const bool lambdaOkay(const std::vector<ramp_msgs::MotionState> segment_points, const double lambda) const;
 
-  // Build a JointTrajectoryPoint from Reflexxes data
-  const trajectory_msgs::JointTrajectoryPoint buildTrajectoryPoint(const ReflexxesData data, bool vertical_line=false);
+  // Build a trajectory point from Reflexxes data
+  void buildTrajectoryPoint(const ReflexxesData& data, MotionSample& point, bool vertical_line=false);
 
   // Print Current and Next vectors
   void printReflexxesSpinInfo() const;
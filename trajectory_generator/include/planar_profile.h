@@ -0,0 +1,515 @@
+#ifndef PLANAR_PROFILE_H
+#define PLANAR_PROFILE_H
+
+#include <math.h>
+
+/**
+ * Native time-optimal motion profiles for the planar DOFs (x, y, theta)
+ *
+ * Header-only replacement for the Type II Reflexxes position interface used by
+ * the motion primitives. All state lives in fixed-size arrays inside the
+ * profile objects, so solving and sampling never allocate and two profiles
+ * never share state. The kinematic helpers are constexpr when compiled as
+ * C++11 and all the types are literal types.
+ *
+ * Two kinds of profile are supported:
+ *  - Trapezoidal (acceleration-limited), the same profiles Reflexxes Type II
+ *    computes, optionally time-synchronized across DOFs
+ *  - Jerk-limited double-S profiles with zero acceleration at both ends
+ */
+
+#if __cplusplus >= 201103L
+#define PROFILE_CONSTEXPR constexpr
+#else
+#define PROFILE_CONSTEXPR inline
+#endif
+
+#define PROFILE_N_DOFS          3
+#define PROFILE_MAX_PHASES      7
+#define PROFILE_MAX_ITERATIONS  100
+#define PROFILE_EPSILON         0.000001
+
+
+PROFILE_CONSTEXPR double profileSign(const double x)
+{
+  return x < 0 ? -1. : 1.;
+}
+
+PROFILE_CONSTEXPR double profileMin(const double a, const double b)
+{
+  return a < b ? a : b;
+}
+
+PROFILE_CONSTEXPR double profileMax(const double a, const double b)
+{
+  return a > b ? a : b;
+}
+
+PROFILE_CONSTEXPR double profileClamp(const double x, const double lo, const double hi)
+{
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// State after moving for dt with constant jerk j
+PROFILE_CONSTEXPR double profilePosition(const double p, const double v, const double a, const double j, const double dt)
+{
+  return p + v*dt + a*dt*dt/2. + j*dt*dt*dt/6.;
+}
+
+PROFILE_CONSTEXPR double profileVelocity(const double v, const double a, const double j, const double dt)
+{
+  return v + a*dt + j*dt*dt/2.;
+}
+
+PROFILE_CONSTEXPR double profileAcceleration(const double a, const double j, const double dt)
+{
+  return a + j*dt;
+}
+
+
+
+/** Piecewise constant-jerk motion of one DOF */
+struct Profile1D {
+
+  // Start time and state of each phase, and the jerk during it
+  double t[PROFILE_MAX_PHASES];
+  double p[PROFILE_MAX_PHASES];
+  double v[PROFILE_MAX_PHASES];
+  double a[PROFILE_MAX_PHASES];
+  double j[PROFILE_MAX_PHASES];
+  unsigned int n;
+
+  // State at the end of the last phase, the motion continues with v_end afterwards
+  double duration;
+  double p_end, v_end, a_end;
+
+
+  void start(const double p0, const double v0)
+  {
+    n         = 0;
+    duration  = 0;
+    p_end     = p0;
+    v_end     = v0;
+    a_end     = 0;
+  }
+
+
+  // Append a phase of length dt, the acceleration may jump to a0 when it begins
+  void addPhase(const double dt, const double a0, const double jerk)
+  {
+    if(dt <= 0 || n >= PROFILE_MAX_PHASES)
+    {
+      return;
+    }
+
+    t[n] = duration;
+    p[n] = p_end;
+    v[n] = v_end;
+    a[n] = a0;
+    j[n] = jerk;
+    n++;
+
+    p_end     = profilePosition(p_end, v_end, a0, jerk, dt);
+    v_end     = profileVelocity(v_end, a0, jerk, dt);
+    a_end     = profileAcceleration(a0, jerk, dt);
+    duration += dt;
+  }
+
+
+  void at(const double time, double& p_t, double& v_t, double& a_t) const
+  {
+    if(time >= duration || n == 0)
+    {
+      p_t = p_end + v_end*(time - duration);
+      v_t = v_end;
+      a_t = 0;
+      return;
+    }
+
+    unsigned int i = n-1;
+    while(i > 0 && t[i] > time)
+    {
+      i--;
+    }
+
+    double dt = time - t[i];
+    p_t = profilePosition(p[i], v[i], a[i], j[i], dt);
+    v_t = profileVelocity(v[i], a[i], j[i], dt);
+    a_t = profileAcceleration(a[i], j[i], dt);
+  }
+};
+
+
+
+/**
+ * Build v0 -> vp -> vf with full acceleration ramps and a cruise of length tc
+ */
+inline void buildTrapezoid(const double p0, const double v0, const double vp, const double vf,
+    const double a_max, const double tc, Profile1D& result)
+{
+  result.start(p0, v0);
+  result.addPhase(fabs(vp - v0) / a_max, profileSign(vp - v0)*a_max, 0);
+  result.addPhase(tc, 0, 0);
+  result.addPhase(fabs(vf - vp) / a_max, profileSign(vf - vp)*a_max, 0);
+  result.a_end = 0;
+} // End buildTrapezoid
+
+
+
+/**
+ * Time-optimal acceleration-limited motion from (p0, v0) to (pf, vf)
+ * Returns false if the limits are not usable
+ */
+inline bool solveTrapezoidal(const double p0, const double v0, const double pf, double vf,
+    const double v_max, const double a_max, Profile1D& result)
+{
+  if(a_max <= 0 || v_max < 0)
+  {
+    return false;
+  }
+  vf = profileClamp(vf, -v_max, v_max);
+
+  // Distance covered by going straight from v0 to vf decides the direction of the peak
+  double d          = pf - p0;
+  double a_direct   = vf >= v0 ? a_max : -a_max;
+  double d_direct   = (vf*vf - v0*v0) / (2.*a_direct);
+  double s          = d >= d_direct ? 1. : -1.;
+
+  double vp = s * sqrt( profileMax((2.*s*a_max*d + v0*v0 + vf*vf) / 2., 0) );
+  if(fabs(vp) > v_max)
+  {
+    vp = s*v_max;
+  }
+
+  double t1 = fabs(vp - v0) / a_max;
+  double t3 = fabs(vf - vp) / a_max;
+  double d1 = (v0 + vp)*t1 / 2.;
+  double d3 = (vp + vf)*t3 / 2.;
+  double tc = fabs(vp) > PROFILE_EPSILON ? profileMax((d - d1 - d3) / vp, 0) : 0;
+
+  buildTrapezoid(p0, v0, vp, vf, a_max, tc, result);
+  return true;
+} // End solveTrapezoidal
+
+
+
+/**
+ * Acceleration-limited motion from (p0, v0) to (pf, vf) that takes exactly T
+ * The cruise velocity is solved in closed form for the three possible shapes,
+ * returns false if none of them fits in T
+ */
+inline bool solveTrapezoidalInTime(const double p0, const double v0, const double pf, double vf,
+    const double v_max, const double a_max, const double T, Profile1D& result)
+{
+  if(a_max <= 0 || v_max < 0 || T < 0)
+  {
+    return false;
+  }
+  vf = profileClamp(vf, -v_max, v_max);
+
+  double d      = pf - p0;
+  double v_hi   = profileMax(v0, vf);
+  double v_lo   = profileMin(v0, vf);
+  double sq     = (v0*v0 + vf*vf) / 2.;
+  double eps    = PROFILE_EPSILON;
+
+  // Peak above both v0 and vf
+  double B    = a_max*T + v0 + vf;
+  double disc = B*B - 4.*(a_max*d + sq);
+  if(disc >= 0)
+  {
+    double vp = (B - sqrt(disc)) / 2.;
+    double tc = T - (2.*vp - v0 - vf) / a_max;
+    if(vp >= v_hi-eps && vp <= v_max+eps && tc >= -eps)
+    {
+      buildTrapezoid(p0, v0, vp, vf, a_max, profileMax(tc, 0), result);
+      return true;
+    }
+  }
+
+  // Peak below both v0 and vf
+  B     = a_max*T - v0 - vf;
+  disc  = B*B - 4.*(sq - a_max*d);
+  if(disc >= 0)
+  {
+    double vp = (-B + sqrt(disc)) / 2.;
+    double tc = T - (v0 + vf - 2.*vp) / a_max;
+    if(vp <= v_lo+eps && vp >= -v_max-eps && tc >= -eps)
+    {
+      buildTrapezoid(p0, v0, vp, vf, a_max, profileMax(tc, 0), result);
+      return true;
+    }
+  }
+
+  // Cruise velocity between v0 and vf, the ramps cover a fixed distance
+  double tc = T - fabs(vf - v0) / a_max;
+  if(tc > eps)
+  {
+    double d_ramps = fabs(vf - v0) > eps ? (vf*vf - v0*v0) / (2.*profileSign(vf - v0)*a_max) : 0;
+    double vp = (d - d_ramps) / tc;
+    if(vp >= v_lo-eps && vp <= v_hi+eps)
+    {
+      buildTrapezoid(p0, v0, vp, vf, a_max, tc, result);
+      return true;
+    }
+  }
+
+  return false;
+} // End solveTrapezoidalInTime
+
+
+
+/**
+ * Time-optimal jerk-limited (double-S) motion from (p0, v0) to (pf, vf)
+ * with zero acceleration at both ends
+ * Returns false if the boundary velocities cannot be met over the distance
+ */
+inline bool solveJerkLimited(const double p0, const double v0, const double pf, const double vf,
+    const double v_max, const double a_max, const double j_max, Profile1D& result)
+{
+  if(a_max <= 0 || v_max <= 0 || j_max <= 0)
+  {
+    return false;
+  }
+
+  // Solve for a positive displacement and flip the result
+  double sigma  = pf >= p0 ? 1. : -1.;
+  double q      = sigma*(pf - p0);
+  double w0     = profileClamp(sigma*v0, -v_max, v_max);
+  double w1     = profileClamp(sigma*vf, -v_max, v_max);
+
+  // Check that the velocity change fits in the distance
+  double Tj_s = profileMin(sqrt(fabs(w1 - w0) / j_max), a_max / j_max);
+  if(Tj_s < a_max / j_max)
+  {
+    if(q < Tj_s*(w0 + w1))
+    {
+      return false;
+    }
+  }
+  else if(q < (w0 + w1)*(Tj_s + fabs(w1 - w0) / a_max) / 2.)
+  {
+    return false;
+  }
+
+  // Assume v_max is reached
+  double Tj1, Ta, Tj2, Td, Tv;
+  if((v_max - w0)*j_max < a_max*a_max)
+  {
+    Tj1 = sqrt((v_max - w0) / j_max);
+    Ta  = 2.*Tj1;
+  }
+  else
+  {
+    Tj1 = a_max / j_max;
+    Ta  = Tj1 + (v_max - w0) / a_max;
+  }
+
+  if((v_max - w1)*j_max < a_max*a_max)
+  {
+    Tj2 = sqrt((v_max - w1) / j_max);
+    Td  = 2.*Tj2;
+  }
+  else
+  {
+    Tj2 = a_max / j_max;
+    Td  = Tj2 + (v_max - w1) / a_max;
+  }
+
+  Tv = q / v_max - (Ta / 2.)*(1. + w0 / v_max) - (Td / 2.)*(1. + w1 / v_max);
+
+  // Otherwise, shrink the acceleration limit until both ramps fit
+  if(Tv <= 0)
+  {
+    Tv = 0;
+
+    double a_lim    = a_max;
+    bool converged  = false;
+    for(unsigned int i=0;i<PROFILE_MAX_ITERATIONS && !converged;i++)
+    {
+      double Tj     = a_lim / j_max;
+      double delta  = pow(a_lim, 4) / (j_max*j_max) + 2.*(w0*w0 + w1*w1) +
+                      a_lim*(4.*q - 2.*(a_lim / j_max)*(w0 + w1));
+
+      Tj1 = Tj;
+      Tj2 = Tj;
+      Ta  = (a_lim*a_lim / j_max - 2.*w0 + sqrt(delta)) / (2.*a_lim);
+      Td  = (a_lim*a_lim / j_max - 2.*w1 + sqrt(delta)) / (2.*a_lim);
+
+      if(Ta < 0 || Td < 0)
+      {
+        if(fabs(w0 + w1) < PROFILE_EPSILON)
+        {
+          return false;
+        }
+
+        // Only one of the ramps is needed
+        if(Ta < 0)
+        {
+          Ta  = 0;
+          Tj1 = 0;
+          Td  = 2.*q / (w1 + w0);
+          Tj2 = (j_max*q - sqrt(j_max*(j_max*q*q + (w1 + w0)*(w1 + w0)*(w1 - w0)))) / (j_max*(w1 + w0));
+        }
+        else
+        {
+          Td  = 0;
+          Tj2 = 0;
+          Ta  = 2.*q / (w1 + w0);
+          Tj1 = (j_max*q - sqrt(j_max*(j_max*q*q - (w1 + w0)*(w1 + w0)*(w1 - w0)))) / (j_max*(w1 + w0));
+        }
+        converged = true;
+      }
+      else if(Ta >= 2.*Tj && Td >= 2.*Tj)
+      {
+        converged = true;
+      }
+      else
+      {
+        a_lim *= 0.99;
+      }
+    } // end for
+
+    if(!converged)
+    {
+      return false;
+    }
+  } // end if v_max not reached
+
+  double j = sigma*j_max;
+  result.start(p0, v0);
+  result.addPhase(Tj1,          result.a_end, j);
+  result.addPhase(Ta - 2.*Tj1,  result.a_end, 0);
+  result.addPhase(Tj1,          result.a_end, -j);
+  result.addPhase(Tv,           result.a_end, 0);
+  result.addPhase(Tj2,          result.a_end, -j);
+  result.addPhase(Td - 2.*Tj2,  result.a_end, 0);
+  result.addPhase(Tj2,          result.a_end, j);
+  result.a_end = 0;
+
+  return true;
+} // End solveJerkLimited
+
+
+
+
+/** Inputs for a PlanarProfile, laid out like RMLPositionInputParameters */
+struct ProfileInput {
+  double current_p[PROFILE_N_DOFS];
+  double current_v[PROFILE_N_DOFS];
+  double current_a[PROFILE_N_DOFS];
+  double target_p[PROFILE_N_DOFS];
+  double target_v[PROFILE_N_DOFS];
+  double max_v[PROFILE_N_DOFS];
+  double max_a[PROFILE_N_DOFS];
+  double max_j[PROFILE_N_DOFS];
+  bool   selection[PROFILE_N_DOFS];
+
+  // Make all selected DOFs finish together, like ONLY_TIME_SYNCHRONIZATION
+  bool synchronize;
+
+  // Use jerk-limited profiles instead of trapezoidal ones
+  bool jerk_limited;
+};
+
+
+
+/**
+ * Motion of the planar DOFs towards a target
+ * Non-selected DOFs keep their current state, as they do in Reflexxes
+ */
+class PlanarProfile {
+public:
+
+  PlanarProfile() : duration_(0) {}
+
+  // Returns false if a selected DOF could not be solved
+  bool solve(const ProfileInput& in)
+  {
+    input_    = in;
+    duration_ = 0;
+
+    for(unsigned int i=0;i<PROFILE_N_DOFS;i++)
+    {
+      dofs_[i].start(in.current_p[i], in.current_v[i]);
+      if(!in.selection[i])
+      {
+        continue;
+      }
+
+      bool solved = in.jerk_limited &&
+        solveJerkLimited(in.current_p[i], in.current_v[i], in.target_p[i], in.target_v[i],
+            in.max_v[i], in.max_a[i], in.max_j[i], dofs_[i]);
+      if(!solved && !solveTrapezoidal(in.current_p[i], in.current_v[i], in.target_p[i],
+            in.target_v[i], in.max_v[i], in.max_a[i], dofs_[i]))
+      {
+        return false;
+      }
+
+      duration_ = profileMax(duration_, dofs_[i].duration);
+    }
+
+    // Stretch the faster trapezoidal DOFs to the slowest one
+    // A DOF that cannot be stretched keeps its time-optimal profile
+    if(in.synchronize && !in.jerk_limited)
+    {
+      for(unsigned int i=0;i<PROFILE_N_DOFS;i++)
+      {
+        if(in.selection[i] && dofs_[i].duration < duration_)
+        {
+          Profile1D synced;
+          if(solveTrapezoidalInTime(in.current_p[i], in.current_v[i], in.target_p[i], in.target_v[i],
+                in.max_v[i], in.max_a[i], duration_, synced))
+          {
+            dofs_[i] = synced;
+          }
+        }
+      }
+    }
+
+    return true;
+  } // End solve
+
+
+  // State at time t after the start, arrays hold PROFILE_N_DOFS values
+  void at(const double t, double* p, double* v, double* a) const
+  {
+    for(unsigned int i=0;i<PROFILE_N_DOFS;i++)
+    {
+      if(input_.selection[i])
+      {
+        dofs_[i].at(t, p[i], v[i], a[i]);
+      }
+      else
+      {
+        p[i] = input_.current_p[i];
+        v[i] = input_.current_v[i];
+        a[i] = input_.current_a[i];
+      }
+    }
+  }
+
+
+  // True once every selected DOF has reached its target
+  bool finalStateReached(const double t) const
+  {
+    return t >= duration_ - PROFILE_EPSILON;
+  }
+
+  double duration() const
+  {
+    return duration_;
+  }
+
+  const ProfileInput& input() const
+  {
+    return input_;
+  }
+
+private:
+  ProfileInput  input_;
+  Profile1D     dofs_[PROFILE_N_DOFS];
+  double        duration_;
+};
+
+#endif
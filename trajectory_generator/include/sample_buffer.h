@@ -0,0 +1,62 @@
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <vector>
+#include "ramp_msgs/MotionState.h"
+#include "trajectory_msgs/JointTrajectoryPoint.h"
+
+/** Number of samples reserved up front, enough for most 0.1s-sampled trajectories */
+#define SAMPLE_BUFFER_DEFAULT_CAPACITY 512
+
+/**
+ * Flat representation of one trajectory sample (x, y, theta)
+ * Holding the values inline means building a sample never touches the heap
+ */
+struct MotionSample {
+  double positions[3];
+  double velocities[3];
+  double accelerations[3];
+  double time;
+};
+
+
+/**
+ * Monotonic buffer that backs the per-sample objects of a single trajectory request
+ *
+ * Samples are appended into one contiguous block that only grows geometrically,
+ * so generating a trajectory costs a handful of allocations instead of several
+ * per sample. clear() keeps the capacity and the whole block is released at once
+ * when the buffer goes out of scope at the end of the request.
+ */
+class SampleBuffer {
+public:
+
+  SampleBuffer(const size_t capacity=SAMPLE_BUFFER_DEFAULT_CAPACITY);
+  ~SampleBuffer();
+
+  // Append a zeroed sample and return a reference to it
+  MotionSample& next();
+
+  const MotionSample& at(const size_t i) const;
+  const MotionSample& back() const;
+
+  size_t size() const;
+  bool empty() const;
+
+  // Forget all samples but keep the storage for the next request
+  void clear();
+
+  // Convert samples [begin, size) to messages, reserving the output once
+  void appendTo(std::vector<ramp_msgs::MotionState>& result, const size_t begin=0) const;
+  void appendTo(std::vector<trajectory_msgs::JointTrajectoryPoint>& result, const size_t begin=0) const;
+
+  // Conversions for single samples
+  static void toMotionState(const MotionSample& s, ramp_msgs::MotionState& result);
+  static void toTrajectoryPoint(const MotionSample& s, trajectory_msgs::JointTrajectoryPoint& result);
+  static void fromMotionState(const ramp_msgs::MotionState& ms, MotionSample& result);
+
+private:
+  std::vector<MotionSample> samples_;
+};
+
+#endif
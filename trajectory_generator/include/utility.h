@@ -32,23 +32,23 @@ class Utility {
   public:
     Utility();
     
-    const double positionDistance(const std::vector<double> a, const std::vector<double> b) const;
-    const double positionDistance(const trajectory_msgs::JointTrajectoryPoint a, const trajectory_msgs::JointTrajectoryPoint b) const;
+    const double positionDistance(const std::vector<double>& a, const std::vector<double>& b) const;
+    const double positionDistance(const trajectory_msgs::JointTrajectoryPoint& a, const trajectory_msgs::JointTrajectoryPoint& b) const;
 
-    const double findAngleFromAToB(const trajectory_msgs::JointTrajectoryPoint a, const trajectory_msgs::JointTrajectoryPoint b) const;
-    const double findAngleFromAToB(const std::vector<double> a, const std::vector<double> b) const;
+    const double findAngleFromAToB(const trajectory_msgs::JointTrajectoryPoint& a, const trajectory_msgs::JointTrajectoryPoint& b) const;
+    const double findAngleFromAToB(const std::vector<double>& a, const std::vector<double>& b) const;
     const double findAngleFromAToB(const double x_prev, const double y_prev, const double x, const double y) const;
-    const double findAngleToVector(const std::vector<double> p) const;
+    const double findAngleToVector(const std::vector<double>& p) const;
     
     const double findDistanceBetweenAngles(const double a1, const double a2) const;
     
     const double displaceAngle(const double a1, double a2) const;
     
-    const double getEuclideanDist(const trajectory_msgs::JointTrajectoryPoint a, const trajectory_msgs::JointTrajectoryPoint b) const;
-    const double getEuclideanDist(const std::vector<double> a, std::vector<double> b) const;
+    const double getEuclideanDist(const trajectory_msgs::JointTrajectoryPoint& a, const trajectory_msgs::JointTrajectoryPoint& b) const;
+    const double getEuclideanDist(const std::vector<double>& a, const std::vector<double>& b) const;
 
     const uint8_t getQuadrant(const double angle) const;
-    const uint8_t getQuadrantOfVector(const std::vector<double> v) const;
+    const uint8_t getQuadrantOfVector(const std::vector<double>& v) const;
 
     const ramp_msgs::Path getPath(const std::vector<ramp_msgs::MotionState> mps) const;
     const ramp_msgs::Path getPath(const std::vector<ramp_msgs::KnotPoint>   kps) const;
@@ -62,7 +62,7 @@ class Utility {
     const std::string toString(const ramp_msgs::Path path) const;
     const std::string toString(const ramp_msgs::BezierCurve bi) const;
     const std::string toString(const ramp_msgs::RampTrajectory traj) const;
-    const std::string toString(const trajectory_msgs::JointTrajectoryPoint p) const;
+    const std::string toString(const trajectory_msgs::JointTrajectoryPoint& p) const;
     const std::string toString(const ramp_msgs::TrajectoryRequest tr) const;
     const std::string toString(const ramp_msgs::TrajectoryResponse tr) const;
     const std::string toString(const ramp_msgs::TrajectorySrv srv) const;
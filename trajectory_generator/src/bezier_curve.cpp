@@ -112,6 +112,30 @@ void BezierCurve::init(const ramp_msgs::BezierCurve bi, const ramp_msgs::MotionS
 
 
 
+/** 
+ * Set up the control points and constants for a curve without initializing Reflexxes
+ * The curve can be verified but not generated
+ */
+void BezierCurve::initGeometry(const ramp_msgs::BezierCurve bi)
+{
+  segmentPoints_.clear();
+  controlPoints_.clear();
+
+  segmentPoints_  = bi.segmentPoints;
+  l_              = bi.l;
+  ms_max_         = bi.ms_maxVA;
+  ms_init_        = getInitialState();
+
+  u_0_        = bi.u_0;
+  u_dot_0_    = bi.u_dot_0;
+  u_dot_max_  = bi.u_dot_max;
+
+  initControlPoints();
+  calculateConstants();
+} // End initGeometry
+
+
+
 /** Determines if a curve violates angular motion constraints */
 const bool BezierCurve::verify() const 
 {
@@ -957,10 +981,12 @@ const std::vector<ramp_msgs::MotionState> BezierCurve::generateCurve()
     points_.push_back(ms_begin_);
     u_values_.push_back(reflexxesData_.inputParameters->CurrentPositionVector->VecData[0]);
 
+    SampleBuffer samples;
     while(!finalStateReached()) 
     {
-      points_.push_back(spinOnce());
+      spinOnce(samples.next());
     }
+    samples.appendTo(points_);
 
     // Set u_target
     u_target_ = reflexxesData_.inputParameters->TargetPositionVector->VecData[0];
@@ -981,6 +1007,14 @@ const std::vector<ramp_msgs::MotionState> BezierCurve::generateCurve()
 
 
 void BezierCurve::generateCurveOOP()
+{
+  SampleBuffer samples;
+  generateCurveOOP(samples);
+}
+
+
+/** Generate the curve using samples as scratch storage so the points are built with one conversion */
+void BezierCurve::generateCurveOOP(SampleBuffer& samples)
 {
   ////////ROS_INFO("Entered BezierCurve::generateCurve()");
   ////////ROS_INFO("Points so far: ");
@@ -1005,10 +1039,12 @@ void BezierCurve::generateCurveOOP()
     points_.push_back(ms_begin_);
     u_values_.push_back(reflexxesData_.inputParameters->CurrentPositionVector->VecData[0]);
 
+    samples.clear();
     while(!finalStateReached()) 
     {
-      points_.push_back(spinOnce());
+      spinOnce(samples.next());
     }
+    samples.appendTo(points_);
 
     // Set u_target
     u_target_ = reflexxesData_.inputParameters->TargetPositionVector->VecData[0];
@@ -1103,7 +1139,7 @@ const ramp_msgs::MotionState BezierCurve::buildMotionState(const ReflexxesData d
 }
 
 
-void BezierCurve::buildMotionStateOOP(const ReflexxesData& data, ramp_msgs::MotionState& result)
+void BezierCurve::buildMotionStateOOP(const ReflexxesData& data, MotionSample& result)
 {
   // Set variables to make equations more readable
   double u          = reflexxesData_.outputParameters->NewPositionVector->VecData[0];
@@ -1158,29 +1194,28 @@ void BezierCurve::buildMotionStateOOP(const ReflexxesData& data, ramp_msgs::Moti
     ////////ROS_INFO("x_dot_dot: %f     y_dot_dot: %f       theta_dot_dot: %f", x_dot_dot, y_dot_dot, theta_dot_dot);
   }
 
-  // Push values onto MotionState
-  result.positions.push_back(x);
-  result.positions.push_back(y);
-  result.positions.push_back(theta);
+  // Set values of the sample
+  result.positions[0] = x;
+  result.positions[1] = y;
+  result.positions[2] = theta;
 
-  result.velocities.push_back(x_dot);
-  result.velocities.push_back(y_dot);
-  result.velocities.push_back(theta_dot);
+  result.velocities[0] = x_dot;
+  result.velocities[1] = y_dot;
+  result.velocities[2] = theta_dot;
 
-  result.accelerations.push_back(x_dot_dot);
-  result.accelerations.push_back(y_dot_dot);
-  result.accelerations.push_back(theta_dot_dot);
+  result.accelerations[0] = x_dot_dot;
+  result.accelerations[1] = y_dot_dot;
+  result.accelerations[2] = theta_dot_dot;
 }
 
 
 
 
-/** Call Reflexxes once and return the next motion state */
+/** Call Reflexxes once and write the next motion state into result */
 // TODO: Clean up?
-const ramp_msgs::MotionState BezierCurve::spinOnce() 
+void BezierCurve::spinOnce(MotionSample& result) 
 {
   //////ROS_INFO("In BezierCurve::spinOnce()");
-  ramp_msgs::MotionState result;
 
 
   // Call Reflexxes
@@ -1247,5 +1282,4 @@ const ramp_msgs::MotionState BezierCurve::spinOnce()
     *reflexxesData_.outputParameters->NewAccelerationVector;
 
   //////ROS_INFO("Exiting BezierCurve::spinOnce()");
-  return result;
 } // End spinOnce
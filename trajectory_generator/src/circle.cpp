@@ -30,9 +30,14 @@ Circle::~Circle()
 
 const bool Circle::finalStateReached() 
 {
+#ifdef USE_NATIVE_PROFILE
+  return (timeFromStart_.toSec() - CYCLE_TIME_IN_SECONDS >= profile_.duration - PROFILE_EPSILON) 
+      || (timeFromStart_ >= timeCutoff_);
+#else
   //return (reflexxesData_.resultValue == ReflexxesAPI::RML_FINAL_STATE_REACHED);
   return ((reflexxesData_.resultValue == ReflexxesAPI::RML_FINAL_STATE_REACHED) 
       || (timeFromStart_ >= timeCutoff_));
+#endif
 }
 
 void Circle::init(const ramp_msgs::MotionState s) 
@@ -66,7 +71,11 @@ void Circle::init(const ramp_msgs::MotionState s)
   initCircleTheta_ = utility_.findAngleFromAToB(center_.positions, start_.positions);
 
   timeCutoff_ = ros::Duration(5);
+#ifdef USE_NATIVE_PROFILE
+  initProfile();
+#else
   initReflexxes();
+#endif
   //std::cout<<"\nLeaving init\n";
 }
 
@@ -97,36 +106,54 @@ void Circle::initReflexxes() {
 
 
 // TODO: Acceleration
-const ramp_msgs::MotionState Circle::buildMotionState(const ReflexxesData data) {
-  ramp_msgs::MotionState result;
+/** Same motion as initReflexxes, half a turn around the circle at |w| */
+void Circle::initProfile() {
+  solveTrapezoidal(0, fabs(w_), PI, fabs(w_), fabs(w_), 1, profile_);
+  w_prev_ = fabs(w_);
+}
+
 
+void Circle::spinOnceProfile(MotionSample& result) {
+  double phi, w, a;
+  profile_.at(timeFromStart_.toSec(), phi, w, a);
+
+  buildMotionState(phi, w_prev_, result);
+  w_prev_ = w;
+}
+
+
+void Circle::buildMotionState(const ReflexxesData& data, MotionSample& result) {
   
   //std::cout<<"\ndata.outputParameters->NewPositionVector->VecData[0]: "<<data.outputParameters->NewPositionVector->VecData[0];
 
+  buildMotionState(data.outputParameters->NewPositionVector->VecData[0], 
+      data.inputParameters->CurrentVelocityVector->VecData[0], result);
+}
+
+
+/** Build the sample phi radians around the circle, w is the angular velocity of the previous cycle */
+void Circle::buildMotionState(const double phi, const double w, MotionSample& result) {
+
   double circleTheta, orientation;
   // Find the orientation around the circle
   if(w_ > 0) {
-    circleTheta = utility_.displaceAngle(initCircleTheta_, 
-        data.outputParameters->NewPositionVector->VecData[0]);
+    circleTheta = utility_.displaceAngle(initCircleTheta_, phi);
     
-    orientation = utility_.displaceAngle(start_.positions.at(2),
-        data.outputParameters->NewPositionVector->VecData[0]);
+    orientation = utility_.displaceAngle(start_.positions.at(2), phi);
   }
   else {
-    circleTheta = utility_.displaceAngle(initCircleTheta_, 
-        -data.outputParameters->NewPositionVector->VecData[0]);
+    circleTheta = utility_.displaceAngle(initCircleTheta_, -phi);
     
-    orientation = utility_.displaceAngle(start_.positions.at(2),
-        -data.outputParameters->NewPositionVector->VecData[0]);
+    orientation = utility_.displaceAngle(start_.positions.at(2), -phi);
   }
 
   //x^2 + y^2 = (w*r)^2
   //x = sqrt( (w*r)^2 - y^2 )
   double x = fabs(r_)*cos(circleTheta);
   double y = fabs(r_)*sin(circleTheta);
-  result.positions.push_back(x+center_.positions.at(0));
-  result.positions.push_back(y+center_.positions.at(1));
-  result.positions.push_back(orientation);
+  result.positions[0] = x+center_.positions.at(0);
+  result.positions[1] = y+center_.positions.at(1);
+  result.positions[2] = orientation;
 
   /*std::cout<<"\ntheta: "<<circleTheta<<" (x,y): ("<<x<<","<<y<<")";
   std::cout<<"\nx+center_.positions.at(0): "<<x+center_.positions.at(0);
@@ -134,39 +161,36 @@ const ramp_msgs::MotionState Circle::buildMotionState(const ReflexxesData data)
 
   
   
-  double phi = data.outputParameters->NewPositionVector->VecData[0];
-  double theta = utility_.findAngleToVector(result.positions);
+  double theta = utility_.findAngleFromAToB(0, 0, result.positions[0], result.positions[1]);
   
   double x_dot = v_*cos(phi)*sin(theta);
   double y_dot = v_*cos(phi)*cos(theta);
 
-  result.velocities.push_back(x_dot);
-  result.velocities.push_back(y_dot);
-  result.velocities.push_back(data.inputParameters->CurrentVelocityVector->VecData[0]);
+  result.velocities[0] = x_dot;
+  result.velocities[1] = y_dot;
+  result.velocities[2] = w;
 
   // TODO: Compute acceleration properly
-  result.accelerations.push_back(0);
-  result.accelerations.push_back(0);
-  result.accelerations.push_back(0);
+  result.accelerations[0] = 0;
+  result.accelerations[1] = 0;
+  result.accelerations[2] = 0;
 
   result.time = timeFromStart_.toSec();
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
-
-  return result;
 }
 
 
 // v = w*r
 // sqrt(x^2 + y^2) = theta_dot * r
-const ramp_msgs::MotionState Circle::spinOnce() {
+void Circle::spinOnce(MotionSample& result) {
   // Calling the Reflexxes OTG algorithm
   reflexxesData_.resultValue = 
     reflexxesData_.rml->RMLPosition(*reflexxesData_.inputParameters, 
                                     reflexxesData_.outputParameters, 
                                     reflexxesData_.flags);
 
-  /** Build the JointTrajectoryPoint object that will be used to build the trajectory */
-  ramp_msgs::MotionState result = buildMotionState(reflexxesData_);
+  /** Build the sample that will be used to build the trajectory */
+  buildMotionState(reflexxesData_, result);
 
   // The input of the next iteration is the output of this one
   *reflexxesData_.inputParameters->CurrentPositionVector = 
@@ -175,25 +199,24 @@ const ramp_msgs::MotionState Circle::spinOnce() {
       *reflexxesData_.outputParameters->NewVelocityVector;
   *reflexxesData_.inputParameters->CurrentAccelerationVector = 
       *reflexxesData_.outputParameters->NewAccelerationVector;
-
-  return result;
 }
 
-const std::vector<ramp_msgs::MotionState> Circle::generatePoints() {
+/** Generate the points of the circle into result, one sample per cycle */
+void Circle::generatePoints(SampleBuffer& result) {
   //std::cout<<"\nIn generatePoints\n";
-  std::vector<ramp_msgs::MotionState> result;
-
 
-  result.push_back(start_);
+  SampleBuffer::fromMotionState(start_, result.next());
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
 
   reflexxesData_.resultValue = 0;
 
   while(!finalStateReached()) {
-    result.push_back(spinOnce());
+#ifdef USE_NATIVE_PROFILE
+    spinOnceProfile(result.next());
+#else
+    spinOnce(result.next());
+#endif
   }
-
-  return result;
 }
 
 
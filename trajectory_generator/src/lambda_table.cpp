@@ -0,0 +1,248 @@
+#include "lambda_table.h"
+
+#define LAMBDA_TABLE_MIN_RATIO  -4.
+#define LAMBDA_TABLE_MAX_RATIO   4.
+#define LAMBDA_TABLE_MIN_LENGTH -3.
+#define LAMBDA_TABLE_MAX_LENGTH  5.
+
+LambdaTable::LambdaTable() : built_(false) {}
+
+LambdaTable::~LambdaTable() {}
+
+
+const bool LambdaTable::built() const
+{
+  return built_;
+}
+
+
+const int LambdaTable::getIndex(const int i_heading, const int i_turn, const int i_ratio, const int i_length) const
+{
+  return ((i_heading*LAMBDA_TABLE_N_TURN + i_turn)*LAMBDA_TABLE_N_RATIO + i_ratio)*LAMBDA_TABLE_N_LENGTH + i_length;
+}
+
+
+const int LambdaTable::getBucket(const double value, const double min, const double max, const int n) const
+{
+  int i = (int)floor( (value - min) / ((max - min) / n) );
+  if(i < 0)
+  {
+    i = 0;
+  }
+  else if(i >= n)
+  {
+    i = n-1;
+  }
+  return i;
+}
+
+
+const double LambdaTable::getBucketCenter(const int i, const double min, const double max, const int n) const
+{
+  double width = (max - min) / n;
+  return min + (i+0.5)*width;
+}
+
+
+const bool LambdaTable::sameLimits(const ramp_msgs::MotionState& ms_maxVA) const
+{
+  if(ms_maxVA.velocities.size() != ms_maxVA_.velocities.size() || 
+      ms_maxVA.accelerations.size() != ms_maxVA_.accelerations.size())
+  {
+    return false;
+  }
+
+  for(uint8_t i=0;i<ms_maxVA.velocities.size();i++)
+  {
+    if(fabs(ms_maxVA.velocities.at(i) - ms_maxVA_.velocities.at(i)) > 0.0001)
+    {
+      return false;
+    }
+  }
+  for(uint8_t i=0;i<ms_maxVA.accelerations.size();i++)
+  {
+    if(fabs(ms_maxVA.accelerations.at(i) - ms_maxVA_.accelerations.at(i)) > 0.0001)
+    {
+      return false;
+    }
+  }
+
+  return true;
+} // End sameLimits
+
+
+/** Same check as the geometric part of MobileBase::lambdaOkay */
+const bool LambdaTable::shapeOkay(const std::vector<ramp_msgs::MotionState>& segment_points, const double lambda) const
+{
+  const std::vector<double>& p0 = segment_points.at(0).positions;
+  const std::vector<double>& p1 = segment_points.at(1).positions;
+  const std::vector<double>& p2 = segment_points.at(2).positions;
+
+  double l_s1 = utility_.positionDistance(p1, p0);
+  double l_s2 = utility_.positionDistance(p2, p1);
+
+  double x0, y0, x2, y2;
+  if(l_s2 < l_s1) 
+  {
+    x2 = (1-lambda)*p1.at(0) + lambda*p2.at(0);
+    y2 = (1-lambda)*p1.at(1) + lambda*p2.at(1);
+
+    double theta = utility_.findAngleFromAToB(p0, p1);
+    x0 = p1.at(0) - l_s2*cos(theta);
+    y0 = p1.at(1) - l_s2*sin(theta);
+  }
+  else 
+  {
+    x0 = (1-lambda)*p0.at(0) + lambda*p1.at(0);
+    y0 = (1-lambda)*p0.at(1) + lambda*p1.at(1);
+
+    double theta = utility_.findAngleFromAToB(p1, p2);
+    x2 = p1.at(0) + l_s2*cos(theta);
+    y2 = p1.at(1) + l_s2*sin(theta);
+  }
+
+  return !(p1.at(0) == (x0 + x2) / 2. && p1.at(1) == (y0 + y2) / 2.);
+} // End shapeOkay
+
+
+/** Returns the lambda the MobileBase search finds for segment_points, or -1 if none verifies */
+const double LambdaTable::search(const std::vector<ramp_msgs::MotionState>& segment_points, const ramp_msgs::MotionState& ms_maxVA, const bool transition) const
+{
+  double lambda = transition ? 0.1 : 0.85;
+
+  // getControlPointLambda
+  bool loopedOnce=false;
+  while(!shapeOkay(segment_points, lambda) && !loopedOnce) 
+  {
+    lambda += transition ? 0.05 : -0.05;
+
+    if(lambda > 0.91) 
+    {
+      lambda = 0.1;
+      loopedOnce = true;
+    }
+    else if(lambda < 0.05) 
+    {
+      lambda = 0.9;
+      loopedOnce = true;
+    }
+  }
+
+  // Verify loop in MobileBase::bezier
+  ramp_msgs::BezierCurve bi;
+  bi.segmentPoints  = segment_points;
+  bi.ms_maxVA       = ms_maxVA;
+  bi.l              = lambda;
+
+  BezierCurve bc;
+  bc.initGeometry(bi);
+  bool verified = bc.verify();
+
+  while(shapeOkay(segment_points, lambda) && lambda > 0.09 && lambda < 0.91 && !verified)
+  {
+    lambda += transition ? 0.05 : -0.05;
+
+    bi.l = lambda;
+    bc.initGeometry(bi);
+    verified = bc.verify();
+  }
+
+  return verified ? lambda : -1;
+} // End search
+
+
+/** Build the table by searching for the lambda of the curve at the center of every cell */
+void LambdaTable::build(const ramp_msgs::MotionState& ms_maxVA)
+{
+  int size = LAMBDA_TABLE_N_HEADING * LAMBDA_TABLE_N_TURN * LAMBDA_TABLE_N_RATIO * LAMBDA_TABLE_N_LENGTH;
+  hybrid_.assign(size, -1);
+  transition_.assign(size, -1);
+
+  std::vector<ramp_msgs::MotionState> segment_points(3);
+  for(uint8_t i=0;i<3;i++)
+  {
+    segment_points.at(i).positions.resize(3);
+  }
+
+  for(int i_h=0;i_h<LAMBDA_TABLE_N_HEADING;i_h++)
+  {
+    double heading = getBucketCenter(i_h, -PI, PI, LAMBDA_TABLE_N_HEADING);
+
+    for(int i_t=0;i_t<LAMBDA_TABLE_N_TURN;i_t++)
+    {
+      double turn = getBucketCenter(i_t, -PI, PI, LAMBDA_TABLE_N_TURN);
+      double heading_2 = utility_.displaceAngle(heading, turn);
+
+      for(int i_r=0;i_r<LAMBDA_TABLE_N_RATIO;i_r++)
+      {
+        double ratio = pow(2., getBucketCenter(i_r, LAMBDA_TABLE_MIN_RATIO, LAMBDA_TABLE_MAX_RATIO, 
+              LAMBDA_TABLE_N_RATIO));
+
+        for(int i_l=0;i_l<LAMBDA_TABLE_N_LENGTH;i_l++)
+        {
+          double l_s1 = pow(2., getBucketCenter(i_l, LAMBDA_TABLE_MIN_LENGTH, LAMBDA_TABLE_MAX_LENGTH, 
+                LAMBDA_TABLE_N_LENGTH));
+          double l_s2 = l_s1 * ratio;
+
+          // Canonical curve starting at the origin
+          segment_points.at(0).positions.at(0) = 0;
+          segment_points.at(0).positions.at(1) = 0;
+          segment_points.at(0).positions.at(2) = heading;
+
+          segment_points.at(1).positions.at(0) = l_s1*cos(heading);
+          segment_points.at(1).positions.at(1) = l_s1*sin(heading);
+          segment_points.at(1).positions.at(2) = heading;
+
+          segment_points.at(2).positions.at(0) = segment_points.at(1).positions.at(0) + l_s2*cos(heading_2);
+          segment_points.at(2).positions.at(1) = segment_points.at(1).positions.at(1) + l_s2*sin(heading_2);
+          segment_points.at(2).positions.at(2) = heading_2;
+
+          int i = getIndex(i_h, i_t, i_r, i_l);
+          hybrid_.at(i)     = search(segment_points, ms_maxVA, false);
+          transition_.at(i) = search(segment_points, ms_maxVA, true);
+        } // end for length
+      } // end for ratio
+    } // end for turn
+  } // end for heading
+
+  ms_maxVA_ = ms_maxVA;
+  built_    = true;
+} // End build
+
+
+const bool LambdaTable::lookup(const std::vector<ramp_msgs::MotionState>& segment_points, const ramp_msgs::MotionState& ms_maxVA, 
+    const bool transition, double& lambda) const
+{
+  if(!built_ || segment_points.size() < 3 || !sameLimits(ms_maxVA))
+  {
+    return false;
+  }
+
+  double l_s1 = utility_.positionDistance(segment_points.at(0).positions, segment_points.at(1).positions);
+  double l_s2 = utility_.positionDistance(segment_points.at(1).positions, segment_points.at(2).positions);
+  if(l_s1 < 0.01 || l_s2 < 0.01)
+  {
+    return false;
+  }
+
+  // Segments outside of the table are left to the search
+  double ratio  = log(l_s2 / l_s1) / log(2.);
+  double length = log(l_s1) / log(2.);
+  if(ratio < LAMBDA_TABLE_MIN_RATIO || ratio > LAMBDA_TABLE_MAX_RATIO ||
+      length < LAMBDA_TABLE_MIN_LENGTH || length > LAMBDA_TABLE_MAX_LENGTH)
+  {
+    return false;
+  }
+
+  double heading    = utility_.findAngleFromAToB(segment_points.at(0).positions, segment_points.at(1).positions);
+  double heading_2  = utility_.findAngleFromAToB(segment_points.at(1).positions, segment_points.at(2).positions);
+  double turn       = utility_.findDistanceBetweenAngles(heading, heading_2);
+
+  int i = getIndex( getBucket(heading, -PI, PI, LAMBDA_TABLE_N_HEADING),
+                    getBucket(turn, -PI, PI, LAMBDA_TABLE_N_TURN),
+                    getBucket(ratio, LAMBDA_TABLE_MIN_RATIO, LAMBDA_TABLE_MAX_RATIO, LAMBDA_TABLE_N_RATIO),
+                    getBucket(length, LAMBDA_TABLE_MIN_LENGTH, LAMBDA_TABLE_MAX_LENGTH, LAMBDA_TABLE_N_LENGTH));
+
+  lambda = transition ? transition_.at(i) : hybrid_.at(i);
+  return lambda > 0;
+} // End lookup
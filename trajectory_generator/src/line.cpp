@@ -25,24 +25,22 @@ Line::~Line() {
 }
 
 
-const ramp_msgs::MotionState Line::buildMotionState(const ReflexxesData data) 
+void Line::buildMotionState(const ReflexxesData& data, MotionSample& result) 
 {
-  ramp_msgs::MotionState result;
-
   for(unsigned int i=0;i<reflexxesData_.NUMBER_OF_DOFS;i++) {
       
     // If Reflexxes has not been called yet
     if(data.outputParameters->NewPositionVector->VecData[0] == -99) {
-      result.positions.push_back(data.inputParameters->CurrentPositionVector->VecData[i]);
-      result.velocities.push_back(data.inputParameters->CurrentVelocityVector->VecData[i]);
-      result.accelerations.push_back(data.inputParameters->CurrentAccelerationVector->VecData[i]);
+      result.positions[i]     = data.inputParameters->CurrentPositionVector->VecData[i];
+      result.velocities[i]    = data.inputParameters->CurrentVelocityVector->VecData[i];
+      result.accelerations[i] = data.inputParameters->CurrentAccelerationVector->VecData[i];
     }
     
     // If selection vector is true
     else if(reflexxesData_.inputParameters->SelectionVector->VecData[i]) {
-      result.positions.push_back(data.outputParameters->NewPositionVector->VecData[i]);
-      result.velocities.push_back(data.outputParameters->NewVelocityVector->VecData[i]);
-      result.accelerations.push_back(data.outputParameters->NewAccelerationVector->VecData[i]);
+      result.positions[i]     = data.outputParameters->NewPositionVector->VecData[i];
+      result.velocities[i]    = data.outputParameters->NewVelocityVector->VecData[i];
+      result.accelerations[i] = data.outputParameters->NewAccelerationVector->VecData[i];
 
       /*if(i == 2) {
         result.positions.at(2) = utility_.displaceAngle(prevKP_.positions.at(2), 
@@ -77,27 +75,32 @@ const ramp_msgs::MotionState Line::buildMotionState(const ReflexxesData data)
       
     // Else, just push on the current value
     else {
-      result.positions.push_back(
-          reflexxesData_.inputParameters->CurrentPositionVector->VecData[i]);
-      result.velocities.push_back(
-          reflexxesData_.inputParameters->CurrentVelocityVector->VecData[i]);
-      result.accelerations.push_back(
-          reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[i]);
+      result.positions[i] = 
+          reflexxesData_.inputParameters->CurrentPositionVector->VecData[i];
+      result.velocities[i] = 
+          reflexxesData_.inputParameters->CurrentVelocityVector->VecData[i];
+      result.accelerations[i] = 
+          reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[i];
     }
   }
 
   result.time = timeFromStart_.toSec();
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
-
-  //std::cout<<"\nresult: "<<utility_.toString(result)<<"\n";
-  return result;
 }
 
 
 
 const bool Line::finalStateReached() 
 {
+#ifdef USE_NATIVE_PROFILE
+  double t = timeFromStart_.toSec() - CYCLE_TIME_IN_SECONDS;
 
+  bool position_goal_met = fabs( profile_.input().target_p[0] - current_.positions[0] ) < 0.01;
+  bool velocity_goal_met = fabs( profile_.input().target_v[1] - current_.velocities[1] ) < 0.01;
+
+  return (profile_.finalStateReached(t) || (position_goal_met && velocity_goal_met) || 
+      (timeFromStart_ >= timeCutoff_));
+#else
 
   bool position_goal_met = fabs( reflexxesData_.inputParameters->TargetPositionVector->VecData[0]- reflexxesData_.inputParameters->CurrentPositionVector->VecData[0] ) < 0.01;
   bool velocity_goal_met = fabs( reflexxesData_.inputParameters->TargetVelocityVector->VecData[1]- reflexxesData_.inputParameters->CurrentVelocityVector->VecData[1] ) < 0.01;
@@ -106,22 +109,25 @@ const bool Line::finalStateReached()
   //return (reflexxesData_.resultValue == ReflexxesAPI::RML_FINAL_STATE_REACHED);
   return (reflexxesData_.resultValue == ReflexxesAPI::RML_FINAL_STATE_REACHED || goal_reached || 
       (timeFromStart_ >= timeCutoff_));
+#endif
 }
 
   
-const std::vector<ramp_msgs::MotionState> Line::generatePoints() {
-  std::vector<ramp_msgs::MotionState> result;
+/** Generate the points of the line into result, one sample per cycle */
+void Line::generatePoints(SampleBuffer& result) {
 
-  result.push_back(start_);
+  SampleBuffer::fromMotionState(start_, result.next());
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
 
   reflexxesData_.resultValue = 0;
 
   while(!finalStateReached()) {
-    result.push_back(spinOnce()); 
+#ifdef USE_NATIVE_PROFILE
+    spinOnceProfile(result.next());
+#else
+    spinOnce(result.next()); 
+#endif
   }
-
-  return result;
 }
 
 
@@ -135,12 +141,65 @@ void Line::init(const ramp_msgs::MotionState start,
   
   timeCutoff_ = ros::Duration(35);
 
+#ifdef USE_NATIVE_PROFILE
+  initProfile();
+#else
   initReflexxes();
   setReflexxesCurrent();
   setReflexxesTarget();
   setReflexxesSelection();
+#endif
 }
 
+
+/** Same inputs as initReflexxes and the setReflexxes* methods, for the native profile */
+void Line::initProfile() 
+{
+  timeFromStart_ = ros::Duration(0);
+
+  ProfileInput in;
+  for(unsigned int i=0;i<PROFILE_N_DOFS;i++) 
+  {
+    in.current_p[i] = start_.positions.at(i);
+    in.current_v[i] = start_.velocities.size() > 0 ? start_.velocities.at(i) : 0;
+    in.current_a[i] = start_.accelerations.size() > 0 ? start_.accelerations.at(i) : 0;
+    in.max_v[i]     = start_.velocities.size() > 0 ? fabs(start_.velocities.at(i)) : 0;
+
+    in.target_p[i]  = goal_.positions.at(i);
+    in.target_v[i]  = 0;
+    if(goal_.velocities.size() > 0) 
+    {
+      if(goal_.velocities.at(i) == 0) 
+      {
+        in.target_v[i]  = 0.00000000000000001;
+        in.max_v[i]     = 0.00000000000000001;
+      }
+      else 
+      {
+        in.target_v[i] = goal_.velocities.at(i);
+      }
+    }
+  }
+
+  in.max_a[0] = 0.66;
+  in.max_a[1] = 0.66;
+  in.max_a[2] = PI/4;
+  in.max_j[0] = 1;
+  in.max_j[1] = 1;
+  in.max_j[2] = PI/3;
+
+  in.selection[0] = true;
+  in.selection[1] = true;
+  in.selection[2] = false;
+
+  // Use time synchronization so the robot drives in a straight line towards goal 
+  in.synchronize  = true;
+  in.jerk_limited = false;
+
+  profile_.solve(in);
+  SampleBuffer::fromMotionState(start_, current_);
+} // End initProfile
+
 void Line::initReflexxes() {
   // Set DOF
   reflexxesData_.NUMBER_OF_DOFS = 3;
@@ -261,7 +320,7 @@ void Line::setReflexxesSelection() {
 }
 
 
-const ramp_msgs::MotionState Line::spinOnce() {
+void Line::spinOnce(MotionSample& result) {
   // Calling the Reflexxes OTG algorithm
   reflexxesData_.resultValue = 
     reflexxesData_.rml->RMLPosition(*reflexxesData_.inputParameters, 
@@ -269,8 +328,8 @@ const ramp_msgs::MotionState Line::spinOnce() {
                                     reflexxesData_.flags);
 
 
-  /** Build the JointTrajectoryPoint object that will be used to build the trajectory */
-  ramp_msgs::MotionState result = buildMotionState(reflexxesData_);
+  /** Build the sample that will be used to build the trajectory */
+  buildMotionState(reflexxesData_, result);
 
 
   // The input of the next iteration is the output of this one
@@ -280,6 +339,15 @@ const ramp_msgs::MotionState Line::spinOnce() {
       *reflexxesData_.outputParameters->NewVelocityVector;
   *reflexxesData_.inputParameters->CurrentAccelerationVector = 
       *reflexxesData_.outputParameters->NewAccelerationVector;
+}
+
+
+
+void Line::spinOnceProfile(MotionSample& result) 
+{
+  result.time = timeFromStart_.toSec();
+  profile_.at(result.time, result.positions, result.velocities, result.accelerations);
+  timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
 
-  return result;
+  current_ = result;
 }
@@ -11,6 +11,9 @@
 
 Utility utility;
 
+// Built once in main, read-only while requests are served
+LambdaTable lambdaTable;
+
 
 void fixDuplicates(ramp_msgs::TrajectoryRequest& req)
 {
@@ -56,6 +59,11 @@ bool requestCallback( ramp_msgs::TrajectorySrv::Request& req,
 {
 
   ros::Time t_start = ros::Time::now();
+  res.resps.reserve(req.reqs.size());
+
+  // One object for the whole batch so Reflexxes is set up once and
+  // paths with the same start share their first segment
+  MobileBase mobileBase(&lambdaTable);
   for(uint8_t i=0;i<req.reqs.size();i++)
   {
     ramp_msgs::TrajectoryRequest treq = req.reqs.at(i); 
@@ -85,7 +93,6 @@ bool requestCallback( ramp_msgs::TrajectorySrv::Request& req,
     {
       fixDuplicates(treq);
       
-      MobileBase mobileBase;
       if(!mobileBase.trajectoryRequest(treq, tres))
       {
         res.error = true;
@@ -125,6 +132,10 @@ int main(int argc, char** argv) {
   // Variable Declaration
   MobileBase mobileBase;
 
+  // Precompute lambda values for the default motion limits used by MobileBase
+  lambdaTable.build(mobileBase.getDefaultMaxMS());
+  ROS_INFO("Lambda table built");
+
   // Declare the service that gives a path and returns a trajectory
   ros::ServiceServer service = n.advertiseService("trajectory_generator", requestCallback);
 
@@ -1,12 +1,16 @@
 #include "mobile_base.h"
 
 /** Constructor */
-MobileBase::MobileBase() : planning_full_(false), i_XDOF_(0), i_THETADOF_(1) 
+MobileBase::MobileBase(const LambdaTable* lambdaTable) : lambdaTable_(lambdaTable), planning_full_(false), i_XDOF_(0), i_THETADOF_(1) 
 {
   reflexxesData_.rml = 0;
   reflexxesData_.inputParameters = 0;
   reflexxesData_.outputParameters = 0;
   MAX_SPEED = 1.f;
+
+  startSegment_.valid             = false;
+  startSegment_.inputParameters   = 0;
+  startSegment_.outputParameters  = 0;
 } 
 
 
@@ -28,6 +32,16 @@ MobileBase::~MobileBase()
     delete reflexxesData_.outputParameters;
     reflexxesData_.outputParameters = 0;
   }
+  if(startSegment_.inputParameters != 0) 
+  {
+    delete startSegment_.inputParameters;
+    startSegment_.inputParameters = 0;
+  }
+  if(startSegment_.outputParameters != 0) 
+  {
+    delete startSegment_.outputParameters;
+    startSegment_.outputParameters = 0;
+  }
 }
 
 
@@ -131,6 +145,99 @@ void MobileBase::init(const ramp_msgs::TrajectoryRequest req)
 
 
 
+/** 
+ * Clear what is left from the previous request
+ * init reads req_ before it is set, so a reused object has to look like a new one
+ */
+void MobileBase::reset()
+{
+  req_ = ramp_msgs::TrajectoryRequest();
+  i_cs.clear();
+} // End reset
+
+
+
+const bool MobileBase::sameMotionState(const ramp_msgs::MotionState& a, const ramp_msgs::MotionState& b) const
+{
+  return a.positions == b.positions && a.velocities == b.velocities && a.accelerations == b.accelerations;
+} // End sameMotionState
+
+
+
+void MobileBase::copyReflexxesState(const RMLPositionInputParameters& in, const RMLPositionOutputParameters& out,
+    RMLPositionInputParameters& in_result, RMLPositionOutputParameters& out_result) const
+{
+  *in_result.CurrentPositionVector      = *in.CurrentPositionVector;
+  *in_result.CurrentVelocityVector      = *in.CurrentVelocityVector;
+  *in_result.CurrentAccelerationVector  = *in.CurrentAccelerationVector;
+  *in_result.TargetPositionVector       = *in.TargetPositionVector;
+  *in_result.TargetVelocityVector       = *in.TargetVelocityVector;
+  *in_result.MaxVelocityVector          = *in.MaxVelocityVector;
+  *in_result.MaxAccelerationVector      = *in.MaxAccelerationVector;
+  *in_result.SelectionVector            = *in.SelectionVector;
+
+  *out_result.NewPositionVector         = *out.NewPositionVector;
+  *out_result.NewVelocityVector         = *out.NewVelocityVector;
+  *out_result.NewAccelerationVector     = *out.NewAccelerationVector;
+} // End copyReflexxesState
+
+
+
+/** Save the trajectory and Reflexxes state after the first knot point */
+void MobileBase::saveStartSegment(const ramp_msgs::TrajectoryRequest& req, const ramp_msgs::TrajectoryResponse& res)
+{
+  if(startSegment_.inputParameters == 0) 
+  {
+    startSegment_.inputParameters = new RMLPositionInputParameters( 
+            reflexxesData_.NUMBER_OF_DOFS );
+
+    startSegment_.outputParameters = new RMLPositionOutputParameters( 
+            reflexxesData_.NUMBER_OF_DOFS );
+  }
+
+  startSegment_.type          = type_;
+  startSegment_.two_points    = req.path.points.size() == 2;
+  startSegment_.start         = path_.points.at(0).motionState;
+  startSegment_.first         = path_.points.at(1).motionState;
+  startSegment_.points        = res.trajectory.trajectory.points;
+  startSegment_.i_knotPoints  = res.trajectory.i_knotPoints;
+  startSegment_.prevKP        = prevKP_;
+  startSegment_.timeFromStart = timeFromStart_;
+  startSegment_.resultValue   = reflexxesData_.resultValue;
+
+  copyReflexxesState(*reflexxesData_.inputParameters, *reflexxesData_.outputParameters,
+      *startSegment_.inputParameters, *startSegment_.outputParameters);
+
+  startSegment_.valid = true;
+} // End saveStartSegment
+
+
+
+/** If the first segment of this request was already generated, continue from it */
+const bool MobileBase::restoreStartSegment(const ramp_msgs::TrajectoryRequest& req, ramp_msgs::TrajectoryResponse& res)
+{
+  if(!startSegment_.valid || startSegment_.type != type_ || 
+      startSegment_.two_points != (req.path.points.size() == 2) ||
+      !sameMotionState(startSegment_.start, path_.points.at(0).motionState) ||
+      !sameMotionState(startSegment_.first, path_.points.at(1).motionState))
+  {
+    return false;
+  }
+
+  res.trajectory.trajectory.points  = startSegment_.points;
+  res.trajectory.i_knotPoints       = startSegment_.i_knotPoints;
+  prevKP_                           = startSegment_.prevKP;
+  timeFromStart_                    = startSegment_.timeFromStart;
+  reflexxesData_.resultValue        = startSegment_.resultValue;
+
+  copyReflexxesState(*startSegment_.inputParameters, *startSegment_.outputParameters,
+      *reflexxesData_.inputParameters, *reflexxesData_.outputParameters);
+
+  return true;
+} // End restoreStartSegment
+
+
+
 /** This method sets the new target of Reflexxes */
 // ********************** Add a check for if there is a target for a non-selected dimension that's
 // different than its current value **********************
@@ -361,7 +468,13 @@ void MobileBase::setInitialMotion()
       }
     }
   }
-  else {//log some error
+  // The input parameters are reused across requests, start from rest like a new object would
+  else 
+  {
+    for(unsigned int i=0;i<reflexxesData_.NUMBER_OF_DOFS;i++) 
+    {
+      reflexxesData_.inputParameters->CurrentVelocityVector->VecData[i] = 0;
+    }
   }
 
   // Set the current accelerations of the robot as Reflexxes input
@@ -383,7 +496,13 @@ void MobileBase::setInitialMotion()
       }
     }
   }
-  else {//log some error
+  // The input parameters are reused across requests, start from rest like a new object would
+  else 
+  {
+    for(unsigned int i=0;i<reflexxesData_.NUMBER_OF_DOFS;i++) 
+    {
+      reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[i] = 0;
+    }
   }
 
   ////////////ROS_INFO("Exiting MobileBase::setInitialMotion");
@@ -398,9 +517,17 @@ void MobileBase::setInitialMotion()
 /** Inserts a MotionState into the response trajectory */
 void MobileBase::insertPoint(const ramp_msgs::MotionState& ms, ramp_msgs::TrajectoryResponse& res) 
 {
-  trajectory_msgs::JointTrajectoryPoint jp = utility_.getTrajectoryPoint(ms);
+  // Build the point in place instead of copying a temporary
+  std::vector<trajectory_msgs::JointTrajectoryPoint>& points = res.trajectory.trajectory.points;
+  points.resize(points.size()+1);
+
+  trajectory_msgs::JointTrajectoryPoint& jp = points.back();
+  jp.positions      = ms.positions;
+  jp.velocities     = ms.velocities;
+  jp.accelerations  = ms.accelerations;
   jp.time_from_start = timeFromStart_;
-  insertPoint(jp, res);
+
+  setCurrent(jp);
 } // End insertPoint
 
 
@@ -408,7 +535,21 @@ void MobileBase::insertPoint(const ramp_msgs::MotionState& ms, ramp_msgs::Trajec
 void MobileBase::insertPoint(const trajectory_msgs::JointTrajectoryPoint& jp, ramp_msgs::TrajectoryResponse& res) 
 {
   res.trajectory.trajectory.points.push_back(jp);
+  setCurrent(jp);
+} // End insertPoint
 
+
+/** Appends a sample at the back of points, converting it in place */
+void MobileBase::appendPoint(const MotionSample& s, std::vector<trajectory_msgs::JointTrajectoryPoint>& points) const
+{
+  points.resize(points.size()+1);
+  SampleBuffer::toTrajectoryPoint(s, points.back());
+} // End appendPoint
+
+
+/** Sets Reflexxes to the point that was just inserted */
+void MobileBase::setCurrent(const trajectory_msgs::JointTrajectoryPoint& jp)
+{
   /** Update Reflexxes */
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
   
@@ -425,7 +566,7 @@ void MobileBase::insertPoint(const trajectory_msgs::JointTrajectoryPoint& jp, ra
   reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[2] = jp.accelerations.at(2);
 
 
-} // End insertPoint
+} // End setCurrent
 
 
 
@@ -500,7 +641,7 @@ const bool MobileBase::lambdaOkay(const std::vector<ramp_msgs::MotionState> segm
 
 
 /** Returns a lambda value that will lead to defined Bezier equations */
-const double MobileBase::getControlPointLambda(const std::vector<ramp_msgs::MotionState> segment_points) const 
+const double MobileBase::getControlPointLambda(const std::vector<ramp_msgs::MotionState> segment_points, const bool useTable) const 
 {
   ////////////ROS_INFO("In MobileBase::getControlPointLambda");
 
@@ -520,7 +661,14 @@ const double MobileBase::getControlPointLambda(const std::vector<ramp_msgs::Moti
     ////////ROS_ERROR("Minimum lambda > 1");
     lambda = min_lambda;
   }
+  // Table values were verified for the default limits, but the caller still verifies them
+  else if(useTable && lambdaTable_ != 0 && lambdaTable_->lookup(segment_points, getMaxMS(), type_ == TRANSITION, lambda) &&
+      lambdaOkay(segment_points, lambda))
+  {
+    ////////////ROS_INFO("lambda from table: %f", lambda);
+  }
   else {
+    lambda = type_ == TRANSITION ? 0.1 : 0.85;
 
     bool loopedOnce=false;
     while(!lambdaOkay(segment_points, lambda) && !loopedOnce) 
@@ -553,6 +701,14 @@ const double MobileBase::getControlPointLambda(const std::vector<ramp_msgs::Moti
 } // End getControlPointLambda
 
 
+const ramp_msgs::MotionState MobileBase::getDefaultMaxMS()
+{
+  initReflexxes();
+  return getMaxMS();
+}
+
+
+
 const ramp_msgs::MotionState MobileBase::getMaxMS() const {
   //////////////////ROS_INFO("In getMaxMS()");
   ramp_msgs::MotionState result;
@@ -688,6 +844,7 @@ const std::vector<BezierCurve> MobileBase::bezier(ramp_msgs::Path& p, const bool
       double theta = utility_.findAngleFromAToB(
           segment_points.at(0).positions, segment_points.at(1).positions);
       double lambda;
+      bool tableLambda = false;
 
       // If we are starting with a curve
       // For transition trajectories, the segment points are the 
@@ -724,7 +881,8 @@ const std::vector<BezierCurve> MobileBase::bezier(ramp_msgs::Path& p, const bool
 
         // Get lambda value for segment points
         lambda = (req_.bezierCurves.at(i-1).controlPoints.size() > 0) ?  req_.bezierCurves.at(i-1).l :
-                                                        getControlPointLambda(segment_points);
+                                                        getControlPointLambda(segment_points, true);
+        tableLambda = req_.bezierCurves.at(i-1).controlPoints.size() == 0;
         ////////////ROS_INFO("lambda: %f", lambda);
 
         ramp_msgs::MotionState ms_maxVA = getMaxMS();
@@ -743,6 +901,25 @@ const std::vector<BezierCurve> MobileBase::bezier(ramp_msgs::Path& p, const bool
 
 
       bool verified = bc.verify();
+
+      // If the table's lambda fails, search from where the search starts without the table
+      double searchLambda = (tableLambda && !verified) ? getControlPointLambda(segment_points) : lambda;
+      if(searchLambda != lambda)
+      {
+        lambda = searchLambda;
+
+        ramp_msgs::BezierCurve bi;
+        bi.segmentPoints  = segment_points;
+        bi.controlPoints  = req_.bezierCurves.at(i-1).controlPoints;
+        bi.l              = lambda;
+        bi.ms_maxVA       = getMaxMS();
+
+        bc.segmentPoints_.clear();
+        bc.controlPoints_.clear();
+        bc.init(bi, path_.points.at(0).motionState);
+
+        verified = bc.verify();
+      }
       // TODO: Implement break in case of infinite loop, print error
       while(lambdaOkay(bc.segmentPoints_, lambda) && lambda > 0.09 && lambda < 0.91 && !verified)
       {
@@ -777,7 +954,7 @@ const std::vector<BezierCurve> MobileBase::bezier(ramp_msgs::Path& p, const bool
         //ROS_INFO("Curve is verified, generating points");
 
         // Generate the curve
-        bc.generateCurveOOP();
+        bc.generateCurveOOP(samples_);
         result.push_back(bc);
       }
       
@@ -990,6 +1167,7 @@ void MobileBase::bezierOOP(ramp_msgs::Path& p, bool only_curve, std::vector<Bezi
       double theta = utility_.findAngleFromAToB(
           segment_points.at(0).positions, segment_points.at(1).positions);
       double lambda;
+      bool tableLambda = false;
 
       // If we are starting with a curve
       // For transition trajectories, the segment points are the 
@@ -1026,7 +1204,8 @@ void MobileBase::bezierOOP(ramp_msgs::Path& p, bool only_curve, std::vector<Bezi
 
         // Get lambda value for segment points
         lambda = (req_.bezierCurves.at(i-1).controlPoints.size() > 0) ?  req_.bezierCurves.at(i-1).l :
-                                                        getControlPointLambda(segment_points);
+                                                        getControlPointLambda(segment_points, true);
+        tableLambda = req_.bezierCurves.at(i-1).controlPoints.size() == 0;
         ////////////ROS_INFO("lambda: %f", lambda);
 
         ramp_msgs::MotionState ms_maxVA = getMaxMS();
@@ -1045,6 +1224,25 @@ void MobileBase::bezierOOP(ramp_msgs::Path& p, bool only_curve, std::vector<Bezi
 
 
       bool verified = bc.verify();
+
+      // If the table's lambda fails, search from where the search starts without the table
+      double searchLambda = (tableLambda && !verified) ? getControlPointLambda(segment_points) : lambda;
+      if(searchLambda != lambda)
+      {
+        lambda = searchLambda;
+
+        ramp_msgs::BezierCurve bi;
+        bi.segmentPoints  = segment_points;
+        bi.controlPoints  = req_.bezierCurves.at(i-1).controlPoints;
+        bi.l              = lambda;
+        bi.ms_maxVA       = getMaxMS();
+
+        bc.segmentPoints_.clear();
+        bc.controlPoints_.clear();
+        bc.init(bi, path_.points.at(0).motionState);
+
+        verified = bc.verify();
+      }
       // TODO: Implement break in case of infinite loop, print error
       while(lambdaOkay(bc.segmentPoints_, lambda) && lambda > 0.09 && lambda < 0.91 && !verified)
       {
@@ -1079,7 +1277,7 @@ void MobileBase::bezierOOP(ramp_msgs::Path& p, bool only_curve, std::vector<Bezi
         ////////////ROS_INFO("Curve is verified, generating points");
 
         // Generate the curve
-        bc.generateCurveOOP();
+        bc.generateCurveOOP(samples_);
         result.push_back(bc);
       }
       
@@ -1277,7 +1475,7 @@ void MobileBase::printReflexxesSpinInfo() const
 
 
 /** Execute one iteration of the Reflexxes control function */
-const trajectory_msgs::JointTrajectoryPoint MobileBase::spinOnce(bool vertical_line) 
+void MobileBase::spinOnce(MotionSample& point, bool vertical_line) 
 {
 
   // Calling the Reflexxes OTG algorithm
@@ -1287,7 +1485,7 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::spinOnce(bool vertical_l
 
 
   /** Build the JointTrajectoryPoint object that will be used to build the trajectory */
-  trajectory_msgs::JointTrajectoryPoint point = buildTrajectoryPoint(reflexxesData_, vertical_line);
+  buildTrajectoryPoint(reflexxesData_, point, vertical_line);
 
   //printReflexxesSpinInfo();
 
@@ -1299,21 +1497,17 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::spinOnce(bool vertical_l
     *reflexxesData_.outputParameters->NewVelocityVector;
   *reflexxesData_.inputParameters->CurrentAccelerationVector = 
     *reflexxesData_.outputParameters->NewAccelerationVector;
-
-  return point;
 } // End spinOnce
 
 
 
 
-/** Given Reflexxes data, return a trajectory point */
-const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(const ReflexxesData data, bool vertical_line) 
+/** Given Reflexxes data, build a trajectory point in point */
+void MobileBase::buildTrajectoryPoint(const ReflexxesData& data, MotionSample& point, bool vertical_line) 
 {
   ////////////ROS_INFO("In MobileBase::buildTrajectoryPoint");
   //printReflexxesSpinInfo();
 
-  trajectory_msgs::JointTrajectoryPoint point;
-
   ////////////ROS_INFO("path_.points.at(i_kp_).motionState: %s", utility_.toString(path_.points.at(i_kp_).motionState).c_str());
   ////////////ROS_INFO("path_.points.at(i_kp_-1).motionState: %s", utility_.toString(path_.points.at(i_kp_-1).motionState).c_str());
   
@@ -1339,9 +1533,9 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
       ////////////ROS_INFO("In if");
       if(i==i_THETADOF_)
       {
-        point.positions.push_back(data.inputParameters->CurrentPositionVector->VecData[i]);
-        point.velocities.push_back(data.inputParameters->CurrentVelocityVector->VecData[i]);
-        point.accelerations.push_back(data.inputParameters->CurrentAccelerationVector->VecData[i]);
+        point.positions[2] = data.inputParameters->CurrentPositionVector->VecData[i];
+        point.velocities[2] = data.inputParameters->CurrentVelocityVector->VecData[i];
+        point.accelerations[2] = data.inputParameters->CurrentAccelerationVector->VecData[i];
       }
       
       else
@@ -1349,22 +1543,22 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
         if(x_diff_greater)
         {
           ////////////ROS_INFO("In x_diff_greater");
-          point.positions.push_back(data.inputParameters->CurrentPositionVector->VecData[i]);
-          point.velocities.push_back(data.inputParameters->CurrentVelocityVector->VecData[i]);
-          point.accelerations.push_back(data.inputParameters->CurrentAccelerationVector->VecData[i]);
+          point.positions[0] = data.inputParameters->CurrentPositionVector->VecData[i];
+          point.velocities[0] = data.inputParameters->CurrentVelocityVector->VecData[i];
+          point.accelerations[0] = data.inputParameters->CurrentAccelerationVector->VecData[i];
           
           
           // Compute y from x
           double b = path_.points.at(i_kp_-1).motionState.positions.at(1) - 
                       (path_.points.at(i_kp_-1).motionState.positions.at(0)*slope);
-          double y = slope*point.positions.at(0) + b;
-          double y_dot = point.velocities.at(0) * tan(theta);
+          double y = slope*point.positions[0] + b;
+          double y_dot = point.velocities[0] * tan(theta);
           double y_ddot = 0;
           
           
-          point.positions.push_back(y);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[1] = y;
+          point.velocities[1] = y_dot;
+          point.accelerations[1] = y_ddot;
         }
         else
         {
@@ -1396,12 +1590,12 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
           ////////////ROS_INFO("x: %f x_dot: %f x_ddot: %f", x, x_dot, x_ddot);
           ////////////ROS_INFO("y: %f y_dot: %f y_ddot: %f", y, y_dot, y_ddot);
           
-          point.positions.push_back(x);
-          point.positions.push_back(y);
-          point.velocities.push_back(x_dot);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(x_ddot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[0] = x;
+          point.positions[1] = y;
+          point.velocities[0] = x_dot;
+          point.velocities[1] = y_dot;
+          point.accelerations[0] = x_ddot;
+          point.accelerations[1] = y_ddot;
         } // end else if y_diff>x_diff
       }
       // Compute y from x
@@ -1426,9 +1620,9 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
       if(i==i_THETADOF_)
       {
         ////////////////ROS_INFO("In i_THETADOF_");
-        point.positions.push_back(data.outputParameters->NewPositionVector->VecData[i]);
-        point.velocities.push_back(data.outputParameters->NewVelocityVector->VecData[i]);
-        point.accelerations.push_back(data.outputParameters->NewAccelerationVector->VecData[i]);
+        point.positions[2] = data.outputParameters->NewPositionVector->VecData[i];
+        point.velocities[2] = data.outputParameters->NewVelocityVector->VecData[i];
+        point.accelerations[2] = data.outputParameters->NewAccelerationVector->VecData[i];
       }
   
       else
@@ -1436,22 +1630,22 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
         if(x_diff_greater)
         {
           ////////////////ROS_INFO("In x_diff_greater");
-          point.positions.push_back(data.outputParameters->NewPositionVector->VecData[i]);
-          point.velocities.push_back(data.outputParameters->NewVelocityVector->VecData[i]);
-          point.accelerations.push_back(data.outputParameters->NewAccelerationVector->VecData[i]);
+          point.positions[0] = data.outputParameters->NewPositionVector->VecData[i];
+          point.velocities[0] = data.outputParameters->NewVelocityVector->VecData[i];
+          point.accelerations[0] = data.outputParameters->NewAccelerationVector->VecData[i];
           
           
           // Compute y from x
           double b = path_.points.at(i_kp_-1).motionState.positions.at(1) - 
                       (path_.points.at(i_kp_-1).motionState.positions.at(0)*slope);
-          double y = slope*point.positions.at(0) + b;
-          double y_dot = point.velocities.at(0) * tan(theta);
+          double y = slope*point.positions[0] + b;
+          double y_dot = point.velocities[0] * tan(theta);
           double y_ddot = 0;
           
           
-          point.positions.push_back(y);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[1] = y;
+          point.velocities[1] = y_dot;
+          point.accelerations[1] = y_ddot;
         }
         else
         {
@@ -1479,12 +1673,12 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
 
           ////////////////ROS_INFO("b: %f y: %f y_dot: %f y_ddot: %f", b, y, y_dot, y_ddot);
           
-          point.positions.push_back(x);
-          point.positions.push_back(y);
-          point.velocities.push_back(x_dot);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(x_ddot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[0] = x;
+          point.positions[1] = y;
+          point.velocities[0] = x_dot;
+          point.velocities[1] = y_dot;
+          point.accelerations[0] = x_ddot;
+          point.accelerations[1] = y_ddot;
         } // end else if y_diff>x_diff
       } // end else if selection vector true
     } // end if selection vector is true
@@ -1510,9 +1704,9 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
 
       // Push on p,v,a
       // TODO: Manually keep acceleration?
-      point.positions.push_back(theta);
-      point.velocities.push_back(w);
-      point.accelerations.push_back(0);
+      point.positions[2] = theta;
+      point.velocities[2] = w;
+      point.accelerations[2] = 0;
 
       // Set values in Reflexxes
       // TODO: Necessary?
@@ -1527,12 +1721,12 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
       if(i==i_THETADOF_)
       {
         ////////////////ROS_INFO("In i_THETADOF_");
-        point.positions.push_back(
-            reflexxesData_.inputParameters->CurrentPositionVector->VecData[i]);
-        point.velocities.push_back(
-            reflexxesData_.inputParameters->CurrentVelocityVector->VecData[i]);
-        point.accelerations.push_back(
-            reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[i]);
+        point.positions[2] = 
+            reflexxesData_.inputParameters->CurrentPositionVector->VecData[i];
+        point.velocities[2] = 
+            reflexxesData_.inputParameters->CurrentVelocityVector->VecData[i];
+        point.accelerations[2] = 
+            reflexxesData_.inputParameters->CurrentAccelerationVector->VecData[i];
       }
       
       else
@@ -1541,22 +1735,22 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
         if(x_diff_greater)
         {
           ////////////////ROS_INFO("In x_diff_greater");
-          point.positions.push_back(data.outputParameters->NewPositionVector->VecData[i]);
-          point.velocities.push_back(data.outputParameters->NewVelocityVector->VecData[i]);
-          point.accelerations.push_back(data.outputParameters->NewAccelerationVector->VecData[i]);
+          point.positions[0] = data.outputParameters->NewPositionVector->VecData[i];
+          point.velocities[0] = data.outputParameters->NewVelocityVector->VecData[i];
+          point.accelerations[0] = data.outputParameters->NewAccelerationVector->VecData[i];
           
           
           // Compute y from x
           double b = path_.points.at(i_kp_-1).motionState.positions.at(1) - 
                       (path_.points.at(i_kp_-1).motionState.positions.at(0)*slope);
-          double y = slope*point.positions.at(0) + b;
-          double y_dot = point.velocities.at(0) * tan(theta);
+          double y = slope*point.positions[0] + b;
+          double y_dot = point.velocities[0] * tan(theta);
           double y_ddot = 0;
           
           
-          point.positions.push_back(y);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[1] = y;
+          point.velocities[1] = y_dot;
+          point.accelerations[1] = y_ddot;
         }
         else
         {
@@ -1586,12 +1780,12 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
           
           ////////////////ROS_INFO("slope: %f theta: %f path_points.at(i_kp-1): %f", slope, theta, path_.points.at(i_kp_-1).motionState.positions.at(1));
 
-          point.positions.push_back(x);
-          point.positions.push_back(y);
-          point.velocities.push_back(x_dot);
-          point.velocities.push_back(y_dot);
-          point.accelerations.push_back(x_ddot);
-          point.accelerations.push_back(y_ddot);
+          point.positions[0] = x;
+          point.positions[1] = y;
+          point.velocities[0] = x_dot;
+          point.velocities[1] = y_dot;
+          point.accelerations[0] = x_ddot;
+          point.accelerations[1] = y_ddot;
         } // end else y_diff>x_diff
       } // end else not at theta
     } // end else selection vector false
@@ -1601,10 +1795,8 @@ const trajectory_msgs::JointTrajectoryPoint MobileBase::buildTrajectoryPoint(con
 
   // The timeFromStart_ is the time of the previous point 
   // plus the cycle period
-  point.time_from_start = timeFromStart_;
+  point.time = timeFromStart_.toSec();
   timeFromStart_ += ros::Duration(CYCLE_TIME_IN_SECONDS);
-
-  return point;
 } // End buildTrajectoryPoint
 
 
@@ -1680,6 +1872,8 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
   //////////ROS_INFO("In MobileBase::trajectoryRequest");
   ////////////ROS_INFO("type_: %i HOLONOMIC: %i", req.type, HOLONOMIC); 
 
+  reset();
+
   // If there's less than 3 points, make it have straight segments
   // if req_.segments == 1
   if( req.path.points.size() < 3 || req.segments == 1 ) 
@@ -1799,6 +1993,9 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
   // Push 0 onto knot point indices
   res.trajectory.i_knotPoints.push_back(0);
 
+  // Reserve enough points for the whole trajectory up front so growing it never copies every point
+  res.trajectory.trajectory.points.reserve( (timeCutoff_.toSec() / CYCLE_TIME_IN_SECONDS) + 1 );
+
   /*if(!checkSpeed(path_, i_cs))
   {
     //////////////ROS_INFO("Check speed is false! Removing knot point 1");
@@ -1831,7 +2028,9 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
     // And set previous knot point
     if(i_kp_ == 1) 
     {
-      res.trajectory.trajectory.points.push_back(buildTrajectoryPoint(reflexxesData_));
+      MotionSample first;
+      buildTrajectoryPoint(reflexxesData_, first);
+      appendPoint(first, res.trajectory.trajectory.points);
       prevKP_ = res.trajectory.trajectory.points.at(0);
     }
     
@@ -1864,6 +2063,13 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
       path_.points.at(i_kp_).motionState.velocities.push_back(0);
     }
   
+    // An earlier request may have generated the same first segment already
+    bool straight = !(c < i_cs.size() && path_.points.size() > 2 && i_kp_ == i_cs.at(c)+1);
+    if(i_kp_ == 1 && straight && restoreStartSegment(req, res))
+    {
+      continue;
+    }
+  
     double y_diff = path_.points.at(i_kp_).motionState.positions.at(1) - prevKP_.positions.at(1);
     double x_diff = path_.points.at(i_kp_).motionState.positions.at(0) - prevKP_.positions.at(0);
     bool x_diff_greater = fabs(x_diff) > fabs(y_diff);
@@ -2013,11 +2219,12 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
         ////////////ROS_INFO("Pushing on points b/c dist: %f", utility_.positionDistance(res.trajectory.trajectory.points.at(res.trajectory.trajectory.points.size()-1).positions, path_.points.at(i_kp_).motionState.positions));
               
         size_t t_size = res.trajectory.trajectory.points.size();
+        MotionSample p;
         // We go to the next knotpoint only once we reach this one
         while (!finalStateReached()) 
         {
 
-          trajectory_msgs::JointTrajectoryPoint p = spinOnce();
+          spinOnce(p);
           ////////////ROS_INFO("p: %s", utility_.toString(p).c_str());
           ////////////ROS_INFO("result: %i", reflexxesData_.resultValue);
           if(reflexxesData_.resultValue == -100)
@@ -2028,7 +2235,7 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
           }
 
           // Compute the motion state at t+1 and save it in the trajectory
-          res.trajectory.trajectory.points.push_back(p);
+          appendPoint(p, res.trajectory.trajectory.points);
         } // end while
 
        
@@ -2056,6 +2263,11 @@ bool MobileBase::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
     prevKP_ = res.trajectory.trajectory.points.at(res.trajectory.trajectory.points.size() - 1);
     //////////////ROS_INFO("After setting new prevKP");
 
+    if(i_kp_ == 1 && straight)
+    {
+      saveStartSegment(req, res);
+    }
+
 
     // Check if Reflexxes overshot target
     /*if(!lastPointClosest(res.trajectory)) 
@@ -2120,11 +2332,11 @@ const std::vector<trajectory_msgs::JointTrajectoryPoint> MobileBase::rotate(cons
   
   // Call Reflexxes until goal is reached
   reflexxesData_.resultValue = 0;
+  MotionSample p;
   while(!finalStateReached()) 
   {
-    trajectory_msgs::JointTrajectoryPoint p = spinOnce();
-    ////////////////ROS_INFO("p: %s", utility_.toString(p).c_str());
-    result.push_back(p);
+    spinOnce(p);
+    appendPoint(p, result);
   }
   
   if(result.size() > 0) 
@@ -2165,11 +2377,11 @@ void MobileBase::rotateOOP(const double start, const double goal, const double s
   
   // Call Reflexxes until goal is reached
   reflexxesData_.resultValue = 0;
+  MotionSample p;
   while(!finalStateReached()) 
   {
-    trajectory_msgs::JointTrajectoryPoint p = spinOnce();
-    ////////////////ROS_INFO("p: %s", utility_.toString(p).c_str());
-    result.push_back(p);
+    spinOnce(p);
+    appendPoint(p, result);
   }
   
   if(result.size() > 0) 
@@ -2211,11 +2423,11 @@ const std::vector<trajectory_msgs::JointTrajectoryPoint> MobileBase::verticalLin
 
   // Call Reflexxes until goal is reached
   reflexxesData_.resultValue = 0;
+  MotionSample p;
   while(!finalStateReached()) 
   {
-    trajectory_msgs::JointTrajectoryPoint p = spinOnce(true);
-    ////////////////ROS_INFO("p: %s", utility_.toString(p).c_str());
-    result.push_back(p);
+    spinOnce(p, true);
+    appendPoint(p, result);
   }
  
   // Restore reflexxes data
@@ -18,10 +18,9 @@ void Prediction::init(const ramp_msgs::TrajectoryRequest req)
 bool Prediction::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs::TrajectoryResponse& res) 
 {
   //ROS_INFO("In Prediction::trajectoryRequest");
-  res.trajectory.i_knotPoints.push_back(0);
-
 
-  std::vector<ramp_msgs::MotionState> traj;
+  // Samples for this request, released in one shot when the request is done
+  SampleBuffer traj;
   
   ramp_msgs::MotionState ms_init = req.path.points.at(0).motionState;
   tf::Vector3 v(ms_init.velocities.at(0), ms_init.velocities.at(1), 0);
@@ -31,13 +30,13 @@ bool Prediction::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
   if(fabs(w) < 0.01 && fabs(vNorm) < 0.01) 
   {
     //ROS_INFO("No velocity, Pushing on one point");
-    traj.push_back(ms_init);
+    SampleBuffer::fromMotionState(ms_init, traj.next());
   }
   
   else if(fabs(w) > 0.01 && fabs(vNorm) < 0.01) 
   {
     //ROS_INFO("Self-rotating, Pushing on one point");
-    traj.push_back(ms_init);
+    SampleBuffer::fromMotionState(ms_init, traj.next());
   }
 
   else if(fabs(req.path.points.at(0).motionState.velocities.at(2)) < 0.01) 
@@ -47,7 +46,7 @@ bool Prediction::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
 
 
     li.init(req.path.points.at(0).motionState, req.path.points.at(1).motionState);
-    traj = li.generatePoints(); 
+    li.generatePoints(traj); 
   }
 
   else if(fabs(req.path.points.at(0).motionState.velocities.at(2)) > 0.01 ) 
@@ -55,26 +54,24 @@ bool Prediction::trajectoryRequest(ramp_msgs::TrajectoryRequest& req, ramp_msgs:
     //ROS_INFO("In circle prediction");
     Circle ci;
     ci.init(req.path.points.at(0).motionState);
-    traj = ci.generatePoints(); 
+    ci.generatePoints(traj); 
   }
   else 
   {
     //ROS_INFO("In else");
-    traj.push_back(req.path.points.at(0).motionState);
+    SampleBuffer::fromMotionState(req.path.points.at(0).motionState, traj.next());
   }
 
   //ROS_INFO("Done with building path");
 
-  ramp_msgs::RampTrajectory rt;
-  for(int i=0;i<traj.size();i++) 
-  {
-    rt.trajectory.points.push_back(utility_.getTrajectoryPoint(traj.at(i)));
-  }
-  res.trajectory = rt;
+  // Convert the samples straight into the response
+  res.trajectory.trajectory.points.clear();
+  traj.appendTo(res.trajectory.trajectory.points);
+  res.trajectory.i_knotPoints.clear();
   res.trajectory.i_knotPoints.push_back(0);
-  res.trajectory.i_knotPoints.push_back(rt.trajectory.points.size()-1);
+  res.trajectory.i_knotPoints.push_back(res.trajectory.trajectory.points.size()-1);
 
-  //ROS_INFO("Predicted trajectory: %s", utility_.toString(rt).c_str());
+  //ROS_INFO("Predicted trajectory: %s", utility_.toString(res.trajectory).c_str());
 
 
   return true;
@@ -0,0 +1,120 @@
+#include "sample_buffer.h"
+#include <string.h>
+
+SampleBuffer::SampleBuffer(const size_t capacity)
+{
+  samples_.reserve(capacity);
+}
+
+SampleBuffer::~SampleBuffer() {}
+
+
+/** Append a zeroed sample to the back of the buffer and return it */
+MotionSample& SampleBuffer::next()
+{
+  MotionSample s;
+  memset(&s, 0, sizeof(MotionSample));
+  samples_.push_back(s);
+  return samples_.back();
+} // End next
+
+
+const MotionSample& SampleBuffer::at(const size_t i) const
+{
+  return samples_.at(i);
+}
+
+const MotionSample& SampleBuffer::back() const
+{
+  return samples_.back();
+}
+
+size_t SampleBuffer::size() const
+{
+  return samples_.size();
+}
+
+bool SampleBuffer::empty() const
+{
+  return samples_.empty();
+}
+
+void SampleBuffer::clear()
+{
+  samples_.clear();
+}
+
+
+/** Convert samples [begin, size) to MotionStates at the back of result */
+void SampleBuffer::appendTo(std::vector<ramp_msgs::MotionState>& result, const size_t begin) const
+{
+  if(begin >= samples_.size())
+  {
+    return;
+  }
+
+  size_t offset = result.size();
+  result.resize(offset + samples_.size() - begin);
+  for(size_t i=begin;i<samples_.size();i++)
+  {
+    toMotionState(samples_[i], result[offset + i - begin]);
+  }
+} // End appendTo
+
+
+/** Convert samples [begin, size) to JointTrajectoryPoints at the back of result */
+void SampleBuffer::appendTo(std::vector<trajectory_msgs::JointTrajectoryPoint>& result, const size_t begin) const
+{
+  if(begin >= samples_.size())
+  {
+    return;
+  }
+
+  size_t offset = result.size();
+  result.resize(offset + samples_.size() - begin);
+  for(size_t i=begin;i<samples_.size();i++)
+  {
+    toTrajectoryPoint(samples_[i], result[offset + i - begin]);
+  }
+} // End appendTo
+
+
+void SampleBuffer::toMotionState(const MotionSample& s, ramp_msgs::MotionState& result)
+{
+  result.positions.assign     (s.positions,     s.positions+3);
+  result.velocities.assign    (s.velocities,    s.velocities+3);
+  result.accelerations.assign (s.accelerations, s.accelerations+3);
+  result.time = s.time;
+} // End toMotionState
+
+
+void SampleBuffer::toTrajectoryPoint(const MotionSample& s, trajectory_msgs::JointTrajectoryPoint& result)
+{
+  result.positions.assign     (s.positions,     s.positions+3);
+  result.velocities.assign    (s.velocities,    s.velocities+3);
+  result.accelerations.assign (s.accelerations, s.accelerations+3);
+  result.time_from_start = ros::Duration(s.time);
+} // End toTrajectoryPoint
+
+
+/** Missing values in ms are left as 0 */
+void SampleBuffer::fromMotionState(const ramp_msgs::MotionState& ms, MotionSample& result)
+{
+  memset(&result, 0, sizeof(MotionSample));
+  for(uint8_t i=0;i<3;i++)
+  {
+    if(i < ms.positions.size())
+    {
+      result.positions[i] = ms.positions[i];
+    }
+    if(i < ms.velocities.size())
+    {
+      result.velocities[i] = ms.velocities[i];
+    }
+    if(i < ms.accelerations.size())
+    {
+      result.accelerations[i] = ms.accelerations[i];
+    }
+  }
+  result.time = ms.time;
+} // End fromMotionState
@@ -20,81 +20,48 @@ const uint8_t Utility::getQuadrant(const double angle) const {
 }
 
 
-const uint8_t Utility::getQuadrantOfVector(const std::vector<double> v) const {
+const uint8_t Utility::getQuadrantOfVector(const std::vector<double>& v) const {
   return getQuadrant( findAngleToVector(v) );
 }
 
 
 
 /** This method returns the Euclidean distance between two position vectors */
-const double Utility::positionDistance(const std::vector<double> a, const std::vector<double> b) const {
+const double Utility::positionDistance(const std::vector<double>& a, const std::vector<double>& b) const {
 
   double d_x = b.at(0) - a.at(0);
   double d_y = b.at(1) - a.at(1);
   return sqrt( pow(d_x,2) + pow(d_y,2) );
 } // End euclideanDistance
 
-const double Utility::positionDistance(const trajectory_msgs::JointTrajectoryPoint point_a, const trajectory_msgs::JointTrajectoryPoint point_b) const {
-  std::vector<double> a,b;
-
-  a.push_back(point_a.positions.at(0));
-  a.push_back(point_a.positions.at(1));
-
-  b.push_back(point_b.positions.at(0));
-  b.push_back(point_b.positions.at(1));
-
-  return positionDistance(a,b);
+const double Utility::positionDistance(const trajectory_msgs::JointTrajectoryPoint& point_a, const trajectory_msgs::JointTrajectoryPoint& point_b) const {
+  return positionDistance(point_a.positions, point_b.positions);
 }
 
-const double Utility::findAngleToVector(const std::vector<double> p) const {
-  std::vector<double> zero;
-  zero.push_back(0); zero.push_back(0);
-
-  return findAngleFromAToB(zero, p);
+const double Utility::findAngleToVector(const std::vector<double>& p) const {
+  return findAngleFromAToB(0, 0, p.at(0), p.at(1));
 }
 
 
-const double Utility::findAngleFromAToB(const trajectory_msgs::JointTrajectoryPoint a, const trajectory_msgs::JointTrajectoryPoint b) const {
-  std::vector<double> c;
-  std::vector<double> d;
-  
-  // Set c
-  for(unsigned int i=0;i<a.positions.size();i++) {
-    c.push_back(a.positions.at(i));
-  }
-  
-  //Set d
-  for(unsigned int i=0;i<b.positions.size();i++) {
-    d.push_back(b.positions.at(i));
-  }
-
-  return findAngleFromAToB(c, d);
+const double Utility::findAngleFromAToB(const trajectory_msgs::JointTrajectoryPoint& a, const trajectory_msgs::JointTrajectoryPoint& b) const {
+  return findAngleFromAToB(a.positions, b.positions);
 }
 
 
 
-const double Utility::findAngleFromAToB(const double x_prev, const double y_prev, const double x, const double y) const {
-  std::vector<double> a, b;
-
-  a.push_back(x_prev);
-  a.push_back(y_prev);
-
-  b.push_back(x);
-  b.push_back(y);
-
-  return findAngleFromAToB(a, b);
+const double Utility::findAngleFromAToB(const std::vector<double>& a, const std::vector<double>& b) const {
+  return findAngleFromAToB(a.at(0), a.at(1), b.at(0), b.at(1));
 }
 
 
-/** This method returns the angle that will form a straight line from position a to position b. a and b are [x, y] vectors. */
-const double Utility::findAngleFromAToB(const std::vector<double> a, const std::vector<double> b) const {
+/** This method returns the angle that will form a straight line from position a to position b. */
+const double Utility::findAngleFromAToB(const double x_prev, const double y_prev, const double x, const double y) const {
   double result;
 
   // Find the distances in x,y directions and Euclidean distance
-  double d_x = b.at(0) - a.at(0);
-  double d_y = b.at(1) - a.at(1);
+  double d_x = x - x_prev;
+  double d_y = y - y_prev;
   double euc_dist = sqrt( pow(d_x,2) + pow(d_y,2) );
-
   
   // If the positions are the same,
   // Set the result to the starting orientation if one is provided
@@ -163,7 +130,7 @@ const double Utility::displaceAngle(const double a1, double a2) const {
 
 
 /** a and b must be the same size */
-const double Utility::getEuclideanDist(const std::vector<double> a, const std::vector<double> b) const {
+const double Utility::getEuclideanDist(const std::vector<double>& a, const std::vector<double>& b) const {
   double result=0;
 
   for(unsigned int i=0;i<a.size();i++) {
@@ -286,7 +253,7 @@ const std::string Utility::toString(const ramp_msgs::Path path) const {
 }
 
 
-const std::string Utility::toString(const trajectory_msgs::JointTrajectoryPoint p) const {
+const std::string Utility::toString(const trajectory_msgs::JointTrajectoryPoint& p) const {
   std::ostringstream result;
 
   //Positions
@@ -10,6 +10,7 @@
 
 // include header file of the fixture tests
 #include "trajectory_generator_fixtureTest.h"
+#include "planar_profile.h"
 
 TEST_F(trajectoryGeneratorFixtureTest, testTrajectoryRequest_Path_3KnotPoints_50ms){
 
@@ -904,6 +905,178 @@ TEST_F(trajectoryGeneratorFixtureTest, testTrajectoryRequest_Path_3KnotPoints_05
 }
 
 
+/** Inputs shared by the Reflexxes and native profile tests, a time-synchronized straight line */
+void seedLineInput(ProfileInput& in)
+{
+  in.current_p[0] = 0.f;    in.current_p[1] = 0.f;    in.current_p[2] = 0.f;
+  in.current_v[0] = 0.5f;   in.current_v[1] = 0.25f;  in.current_v[2] = 0.f;
+  in.current_a[0] = 0.f;    in.current_a[1] = 0.f;    in.current_a[2] = 0.f;
+  in.target_p[0]  = 2.f;    in.target_p[1]  = 1.5f;   in.target_p[2]  = 0.f;
+  in.target_v[0]  = 0.5f;   in.target_v[1]  = 0.25f;  in.target_v[2]  = 0.f;
+  in.max_v[0]     = 0.7f;   in.max_v[1]     = 0.7f;   in.max_v[2]     = PI/4.f;
+  in.max_a[0]     = 0.66f;  in.max_a[1]     = 0.66f;  in.max_a[2]     = PI/4.f;
+  in.max_j[0]     = 1.f;    in.max_j[1]     = 1.f;    in.max_j[2]     = PI/3.f;
+  in.selection[0] = true;   in.selection[1] = true;   in.selection[2] = false;
+  in.synchronize  = true;
+  in.jerk_limited = false;
+}
+
+/**
+ * Inputs for each case the native profile is compared with Reflexxes on, 
+ * the line of seedLineInput changed one way at a time
+ */
+std::vector<ProfileInput> getProfileInputs()
+{
+  std::vector<ProfileInput> result;
+  ProfileInput in;
+
+  // Time-synchronized line at speed
+  seedLineInput(in);
+  result.push_back(in);
+
+  // Rest to rest, long enough to cruise at the velocity limit
+  seedLineInput(in);
+  in.current_v[0] = 0.f;    in.current_v[1] = 0.f;
+  in.target_v[0]  = 0.f;    in.target_v[1]  = 0.f;
+  in.target_p[0]  = 3.f;    in.target_p[1]  = 1.f;
+  result.push_back(in);
+
+  // Rest to rest, too short to reach the velocity limit
+  seedLineInput(in);
+  in.current_v[0] = 0.f;    in.current_v[1] = 0.f;
+  in.target_v[0]  = 0.f;    in.target_v[1]  = 0.f;
+  in.target_p[0]  = 0.2f;   in.target_p[1]  = 0.1f;
+  result.push_back(in);
+
+  // Stop at the target
+  seedLineInput(in);
+  in.target_v[0]  = 0.f;    in.target_v[1]  = 0.f;
+  result.push_back(in);
+
+  // Backwards from rest
+  seedLineInput(in);
+  in.current_v[0] = 0.f;    in.current_v[1] = 0.f;
+  in.target_p[0]  = -1.f;   in.target_p[1]  = -0.5f;
+  in.target_v[0]  = -0.5f;  in.target_v[1]  = -0.25f;
+  result.push_back(in);
+
+  // Rotation in place
+  seedLineInput(in);
+  in.current_v[0] = 0.f;    in.current_v[1] = 0.f;
+  in.target_p[0]  = 0.f;    in.target_p[1]  = 0.f;    in.target_p[2] = PI/2.f;
+  in.target_v[0]  = 0.f;    in.target_v[1]  = 0.f;
+  in.selection[0] = false;  in.selection[1] = false;  in.selection[2] = true;
+  result.push_back(in);
+
+  return result;
+}
+
+/** Run Reflexxes on the same inputs, storing the positions of every cycle */
+int runReflexxes(const ProfileInput& in, std::vector<double>& positions)
+{
+  ReflexxesAPI rml(PROFILE_N_DOFS, CYCLE_TIME_IN_SECONDS);
+  RMLPositionInputParameters  inputParameters(PROFILE_N_DOFS);
+  RMLPositionOutputParameters outputParameters(PROFILE_N_DOFS);
+  RMLPositionFlags flags;
+  flags.SynchronizationBehavior = RMLPositionFlags::ONLY_TIME_SYNCHRONIZATION;
+
+  for(unsigned int i=0;i<PROFILE_N_DOFS;i++)
+  {
+    inputParameters.CurrentPositionVector->VecData[i]     = in.current_p[i];
+    inputParameters.CurrentVelocityVector->VecData[i]     = in.current_v[i];
+    inputParameters.CurrentAccelerationVector->VecData[i] = in.current_a[i];
+    inputParameters.TargetPositionVector->VecData[i]      = in.target_p[i];
+    inputParameters.TargetVelocityVector->VecData[i]      = in.target_v[i];
+    inputParameters.MaxVelocityVector->VecData[i]         = in.max_v[i];
+    inputParameters.MaxAccelerationVector->VecData[i]     = in.max_a[i];
+    inputParameters.MaxJerkVector->VecData[i]             = in.max_j[i];
+    inputParameters.SelectionVector->VecData[i]           = in.selection[i];
+  }
+
+  int result = 0;
+  while(result != ReflexxesAPI::RML_FINAL_STATE_REACHED && result >= 0)
+  {
+    result = rml.RMLPosition(inputParameters, &outputParameters, flags);
+    for(unsigned int i=0;i<PROFILE_N_DOFS;i++)
+    {
+      positions.push_back(outputParameters.NewPositionVector->VecData[i]);
+    }
+
+    *inputParameters.CurrentPositionVector      = *outputParameters.NewPositionVector;
+    *inputParameters.CurrentVelocityVector      = *outputParameters.NewVelocityVector;
+    *inputParameters.CurrentAccelerationVector  = *outputParameters.NewAccelerationVector;
+  }
+
+  return result;
+}
+
+/** Sample the native profile every cycle until it finishes */
+void runNativeProfile(const ProfileInput& in, std::vector<double>& positions)
+{
+  PlanarProfile profile;
+  profile.solve(in);
+
+  double p[PROFILE_N_DOFS], v[PROFILE_N_DOFS], a[PROFILE_N_DOFS];
+  double t = 0;
+  do
+  {
+    t += CYCLE_TIME_IN_SECONDS;
+    profile.at(t, p, v, a);
+    positions.insert(positions.end(), p, p+PROFILE_N_DOFS);
+  } while(!profile.finalStateReached(t));
+}
+
+TEST(planarProfileTest, testNativeProfile_SameOutputAsReflexxes){
+
+    std::vector<ProfileInput> ins = getProfileInputs();
+    for(unsigned int c=0;c<ins.size();c++)
+    {
+      std::vector<double> reflexxes, native;
+      EXPECT_EQ(ReflexxesAPI::RML_FINAL_STATE_REACHED, runReflexxes(ins.at(c), reflexxes))
+                <<"Reflexxes failed on case "<<c;
+      runNativeProfile(ins.at(c), native);
+
+      ASSERT_EQ(reflexxes.size(), native.size())
+                <<"The native profile took a different number of cycles than Reflexxes on case "<<c;
+      for(unsigned int i=0;i<native.size();i++)
+      {
+        EXPECT_NEAR(reflexxes.at(i), native.at(i), 0.001)
+                  <<"The native profile differs from Reflexxes on case "<<c<<" at cycle "<<(i/PROFILE_N_DOFS);
+      }
+    }
+}
+
+/** Timings depend on the machine, so they are reported and not checked */
+TEST(planarProfileTest, testNativeProfile_ReportTiming){
+
+    std::vector<ProfileInput> ins = getProfileInputs();
+    std::vector<double> positions;
+    positions.reserve(1000);
+
+    for(unsigned int c=0;c<ins.size();c++)
+    {
+      double _startTime = ros::WallTime::now().toSec();
+      for(int i=0;i<1000;i++)
+      {
+        positions.clear();
+        runReflexxes(ins.at(c), positions);
+      }
+      double _reflexxesDuration = ros::WallTime::now().toSec() - _startTime;
+
+      _startTime = ros::WallTime::now().toSec();
+      for(int i=0;i<1000;i++)
+      {
+        positions.clear();
+        runNativeProfile(ins.at(c), positions);
+      }
+      double _nativeDuration = ros::WallTime::now().toSec() - _startTime;
+
+      std::cout<<"\nCase "<<c<<": Reflexxes: "<<_reflexxesDuration<<"s native: "<<_nativeDuration<<"s for 1000 profiles";
+    }
+    std::cout<<"\n";
+}
+
+
 //============= Main function of test runer ===================================
 int main(int argc, char **argv) {
     